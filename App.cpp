@@ -1,93 +1,726 @@
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
 
 #include "App.h"
+#include "DeletionIndex.h"
+#include "DictionaryBuilder.h"
+#include "DictionaryIndex.h"
+#include "FilteredDictionary.h"
 #include "FileReader.h"
+#include "LengthDictionary.h"
+#include "MappedFile.h"
+#include "ShardedReader.h"
+#include "Socket.h"
+#include "StringSort.h"
+#include "Trie.h"
+#include "WordGraph.h"
 #include "hash.h"
 
-using std::cout, std::endl, std::string;
+using std::cout, std::string;
 
-// 512K entries, probably around 10MB in RAM
-// The dictionary has around 400K words
-constexpr size_t HASH_TABLE_SIZE = 512*1024;
+// Hash tables grow as needed, this is only an initial size hint.
+// Typical number of unique words in a checked file
+constexpr size_t CHECKED_FILE_WORDS_HINT = 4*1024;
+
+// Smallest part of a checked file read on a thread of its own. Smaller files
+// are read on a single thread
+constexpr size_t PARALLEL_READ_CHUNK_BYTES = 16 << 20;
+
+// Size of the suggestion cache when a cache file is given without a size
+constexpr size_t DEFAULT_CACHE_SIZE = 64*1024;
+
+// Longest wait before accepting again after accepting a client failed
+constexpr std::chrono::milliseconds MAX_ACCEPT_BACKOFF{1000};
+
+// Longest wait for a client in the middle of sending a request or receiving
+// a response, before dropping it
+constexpr std::chrono::milliseconds CLIENT_TIMEOUT{10000};
 
 // negative result if str1<str2, 0 if same string, positive result if str1>str2
-int strings_cmp_callback(string str1, string str2) {
+int strings_cmp_callback(const string& str1, const string& str2) {
     return str1.compare(str2);
 }
 
-App::App(std::string dict_path)
-    : m_dict(hash, HASH_TABLE_SIZE)
-    , m_autocorrect(m_dict) {
-    read_dict(dict_path);
-}
+// A unique word of a checked file and its number of occurrences
+struct CountedWord final {
+    string word;
+    // Not part of the key, so it may change in the table
+    mutable size_t count;
+
+    operator std::string_view() const {
+        return word;
+    }
+    bool operator==(std::string_view other) const {
+        return word == other;
+    }
+};
+
+App::App(std::string dict_path, const Config& config)
+    : m_config(config)
+    , m_writer(cout, std::cerr, ReportWriter::formatOf(config.report_format))
+    , m_hasher(findHasher(config.hash_name))
+    , m_num_words_in_dict_file(0)
+    , m_dict(load_dict(dict_path))
+    , m_dict_fingerprint(config.cache_path.empty() ? 0 : dict_fingerprint())
+    , m_fallback(load_fallback())
+    , m_frequencies(load_frequencies())
+    , m_pool(config.threads)
+    , m_autocorrects(make_autocorrects())
+    , m_cache(load_cache()) {}
 
 App::~App() {}
 
-void App::run(string checked_path) {
+struct App::Report final {
+    // Report of the file up to its misspelled words, buffered until its turn
+    // when checking several files at a time
+    std::ostringstream text;
+    string path;
+    std::vector<string> misspelled;
+    // Occurrences of each misspelled word in the file
+    std::vector<size_t> counts;
+    // Suggestions for the misspelled words, where suggested[w] is set
+    std::vector<suggestions_t> suggestions;
+    std::vector<char> suggested;
+    // Error checking the file, reported in its turn
+    std::exception_ptr error;
+};
+
+void App::run(const std::vector<string>& checked_paths) {
+    if (m_config.jobs <= 1) {
+        for (const auto& path : checked_paths) {
+            Report report;
+            check(path, m_writer.progress(), report, 0, true);
+            finish(report, 0);
+        }
+        return;
+    }
+    // Each file is checked by a single thread, and reported by the thread
+    // which completes the next report due
+    ThreadPool files(m_config.jobs);
+    std::vector<std::unique_ptr<Report>> reports(checked_paths.size());
+    size_t next_report = 0;
+    std::exception_ptr error;
+    std::mutex report_mutex;
+    files.parallelFor(checked_paths.size(), [&](size_t thread, size_t i) {
+        auto report = std::make_unique<Report>();
+        try {
+            check(checked_paths[i], report->text, *report, thread, false);
+        }
+        catch (...) {
+            report->error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(report_mutex);
+        reports[i] = std::move(report);
+        while (!error && next_report < reports.size() && reports[next_report]) {
+            Report& next = *reports[next_report];
+            error = next.error;
+            // func of parallelFor must not throw, so an error writing the
+            // report (e.g. out of memory) is rethrown after the loop too
+            try {
+                m_writer.progress() << next.text.str();
+                if (!error) {
+                    finish(next, thread);
+                }
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            reports[next_report++].reset();
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void App::check(const string& checked_path, std::ostream& out, Report& report, size_t thread, bool use_pool) {
+    out << "\nCheking file '" << checked_path << "'.\n";
+    report.path = checked_path;
+    std::error_code err;
+    size_t file_size = std::filesystem::file_size(checked_path, err);
+    if (use_pool && !m_config.use_tree && !err && file_size >= 2*PARALLEL_READ_CHUNK_BYTES
+        && m_pool.numThreads() > 1) {
+        MappedFile file(checked_path);
+        out << "Reading input file...\n";
+        report.misspelled = find_misspelled_parallel(file, out, report.counts);
+    }
+    else {
+        FileReader fr(checked_path);
+        out << "Reading input file...\n";
+        report.misspelled = m_config.use_tree ? find_misspelled_tree(fr, out, report.counts)
+            : find_misspelled(fr, out, report.counts);
+    }
+    const auto& words = report.misspelled;
+    report.suggestions.assign(words.size(), {});
+    report.suggested.assign(words.size(), false);
+    std::vector<size_t> uncached;
+    {
+        std::lock_guard<std::mutex> lock(m_cache_mutex);
+        for (size_t w = 0; w < words.size(); ++w) {
+            if (!m_cache || !m_cache->contains(words[w])) {
+                uncached.push_back(w);
+            }
+        }
+    }
+    auto suggest_uncached = [&](size_t pool_thread, size_t i) {
+        report.suggestions[uncached[i]] = suggest(m_autocorrects[pool_thread], words[uncached[i]]);
+        report.suggested[uncached[i]] = true;
+    };
+    if (use_pool) {
+        m_pool.parallelFor(uncached.size(), suggest_uncached);
+    }
+    else {
+        for (size_t i = 0; i < uncached.size(); ++i) {
+            suggest_uncached(thread, i);
+        }
+    }
+}
+
+void App::finish(Report& report, size_t thread) {
+    const auto& words = report.misspelled;
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    size_t cache_hits = m_cache ? m_cache->hits() : 0;
+    size_t cache_misses = m_cache ? m_cache->misses() : 0;
+    // A word may have been evicted since it was checked, then it is
+    // suggested for again
+    for (size_t w = 0; m_cache && w < words.size(); ++w) {
+        report.suggestions[w] = suggest_cached(words[w],
+            report.suggested[w] ? &report.suggestions[w] : nullptr, m_autocorrects[thread]);
+    }
+    m_writer.progress() << "The following words are not in the dictionary:\n";
+    for (size_t w = 0; w < words.size(); ++w) {
+        m_writer.misspelled(report.path, words[w], report.counts[w], report.suggestions[w]);
+    }
+    if (m_cache) {
+        m_writer.progress() << "Suggestion cache: " << m_cache->hits() - cache_hits << " hits, "
+            << m_cache->misses() - cache_misses << " misses, " << m_cache->size() << " entries\n";
+    }
+}
+
+void App::stream(const string& checked_path) {
+    m_writer.progress() << "\nStreaming file '" << checked_path << "'.\n";
+    FileReader fr(checked_path);
+    LruCache<string, bool> seen(m_config.stream_seen_cap);
+    size_t num_words = 0;
+    std::string_view word = fr.getWordView();
+    while (!word.empty()) {
+        ++num_words;
+        string key(word);
+        if (!seen.get(key)) {
+            seen.put(key, true);
+            if (!m_dict->lookup(word)) {
+                // Not counted, as the word is reported when first seen
+                m_writer.misspelled(checked_path, key, 0,
+                    m_cache ? suggest_cached(key, nullptr, m_autocorrects[0]) : suggest(m_autocorrects[0], key));
+                m_writer.flush();
+            }
+        }
+        word = fr.getWordView();
+    }
+    m_writer.progress() << "Finished reading input file.\n";
+    m_writer.progress() << "Words in input file: " << num_words << '\n';
+    m_writer.progress() << "Words first seen: " << seen.misses() << " (remembering up to " << seen.capacity()
+        << " at a time)\n";
+}
+
+void App::serve(const string& socket_path) {
+    Socket server = Socket::listen(socket_path);
+    m_writer.progress() << "Serving on '" << socket_path << "'.\n";
+    m_writer.flush();
+    // Each thread of the pool answers a request of a client at a time,
+    // until SIGINT or SIGTERM. Idle clients wait in the poller
+    ClientPoller poller(server);
+    poller.stopOnSignals();
+    ThreadPool workers(m_config.max_clients);
+    workers.parallelFor(workers.numThreads(), [&](size_t, size_t) {
+        Autocorrect autocorrect(*m_dict, m_fallback.get(), m_frequencies.get());
+        // Accepting fails while out of file descriptors or memory, until
+        // other clients disconnect, so wait longer on each failure
+        std::chrono::milliseconds backoff{0};
+        for (;;) {
+            try {
+                std::optional<Socket> client = poller.next();
+                if (!client) {
+                    return;
+                }
+                backoff = std::chrono::milliseconds{0};
+                if (serve_request(*client, autocorrect)) {
+                    poller.add(std::move(*client));
+                }
+            }
+            catch (const std::exception& e) {
+                if (backoff.count() == 0) {
+                    std::cerr << "Error: " << e.what() << '\n';
+                }
+                backoff = std::min(std::max(2*backoff, std::chrono::milliseconds{10}), MAX_ACCEPT_BACKOFF);
+                std::this_thread::sleep_for(backoff);
+            }
+        }
+    });
+}
+
+bool App::serve_request(const Socket& client, Autocorrect& autocorrect) {
+    string request;
+    try {
+        client.setTimeout(CLIENT_TIMEOUT);
+        if (client.receive(request)) {
+            auto start = std::chrono::steady_clock::now();
+            string status = "ok";
+            string body;
+            try {
+                body = respond(request, autocorrect);
+            }
+            catch (const std::exception& e) {
+                status = "error";
+                body = string(e.what()) + "\n";
+            }
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            string response = status + " " + std::to_string(us) + "\n" + body;
+            if (response.length() > Socket::MAX_MESSAGE) {
+                response = "error " + std::to_string(us) + "\nResponse of " + std::to_string(response.length())
+                    + " bytes is too long, send a shorter text\n";
+            }
+            client.send(response);
+            return true;
+        }
+    }
+    catch (const std::exception& e) {
+        // The client is gone, stalled or broke the protocol, drop it
+    }
+    return false;
+}
+
+string App::respond(std::string_view request, Autocorrect& autocorrect) {
+    size_t space = std::min(request.find(' '), request.length());
+    std::string_view command = request.substr(0, space);
+    if (command != "check" && command != "suggest") {
+        throw InvalidOption("Unknown command '" + string(command) + "'");
+    }
+    FileReader fr(request.substr(std::min(space + 1, request.length())));
+    std::unordered_set<string> seen;
+    string body;
+    std::string_view word = fr.getWordView();
+    while (!word.empty()) {
+        auto [it, inserted] = seen.emplace(word);
+        if (inserted && (command == "suggest" || !m_dict->lookup(word))) {
+            body += *it;
+            for (const auto& suggestion : suggest_shared(autocorrect, *it)) {
+                body += "\t" + suggestion.word;
+            }
+            body += "\n";
+        }
+        word = fr.getWordView();
+    }
+    return body;
+}
+
+App::suggestions_t App::suggest_shared(Autocorrect& autocorrect, const string& word) {
+    if (!m_cache) {
+        return suggest(autocorrect, word);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_cache_mutex);
+        if (m_cache->contains(word)) {
+            return suggest_cached(word, nullptr, autocorrect);
+        }
+    }
+    auto suggestions = suggest(autocorrect, word);
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    return suggest_cached(word, &suggestions, autocorrect);
+}
+
+App::suggestions_t App::suggest_cached(const string& word, suggestions_t* suggested, Autocorrect& autocorrect) {
+    // Cached suggestions are kept as tab separated words and strategies, as
+    // in the cache file
+    suggestions_t suggestions;
+    if (const string* cached = m_cache->get(word)) {
+        std::vector<string> fields;
+        for (size_t begin = 0; begin < cached->length();) {
+            size_t end = std::min(cached->find('\t', begin), cached->length());
+            fields.push_back(cached->substr(begin, end - begin));
+            begin = end + 1;
+        }
+        for (size_t i = 0; i + 1 < fields.size(); i += 2) {
+            suggestions.push_back({std::move(fields[i]), std::move(fields[i+1])});
+        }
+        return suggestions;
+    }
+    suggestions = suggested ? std::move(*suggested) : suggest(autocorrect, word);
+    string joined;
+    for (const auto& suggestion : suggestions) {
+        joined += (joined.empty() ? "" : "\t") + suggestion.word + "\t" + suggestion.strategy;
+    }
+    m_cache->put(word, joined);
+    return suggestions;
+}
+
+App::suggestions_t App::suggest(Autocorrect& autocorrect, const string& word) const {
+    suggestions_t suggestions;
+    if (ranked()) {
+        Autocorrect::Budget budget;
+        budget.max_probes = m_config.max_probes;
+        budget.max_time = std::chrono::microseconds(m_config.max_suggest_us);
+        for (auto& suggestion : autocorrect.suggest(word, std::max<size_t>(m_config.top_suggestions, 1), budget)) {
+            suggestions.push_back({std::move(suggestion.word), suggestion.strategy});
+        }
+    }
+    else {
+        const char* strategy = "";
+        string suggestion = autocorrect.attemptAutocorrect(word, &strategy);
+        if (suggestion != "") {
+            suggestions.push_back({suggestion, strategy});
+        }
+    }
+    return suggestions;
+}
+
+std::vector<Autocorrect> App::make_autocorrects() const {
+    std::vector<Autocorrect> autocorrects;
+    for (size_t i = 0; i < std::max(m_pool.numThreads(), m_config.jobs); ++i) {
+        autocorrects.emplace_back(*m_dict, m_fallback.get(), m_frequencies.get());
+    }
+    return autocorrects;
+}
+
+bool App::ranked() const {
+    return m_config.top_suggestions > 0 || !m_config.frequency_path.empty()
+        || m_config.max_probes > 0 || m_config.max_suggest_us > 0;
+}
+
+std::vector<string> App::find_misspelled(FileReader& fr, std::ostream& out, std::vector<size_t>& counts) {
+    Hashtable<CountedWord, std::string_view> seen(m_hasher.func, CHECKED_FILE_WORDS_HINT);
+    std::vector<string> misspelled;
+    size_t num_words = 0;
+    std::string_view word = fr.getWordView();
+    while (!word.empty()) {
+        ++num_words;
+        size_t hash = m_hasher.func(word);
+        if (const CountedWord* counted = seen.find(word, hash)) {
+            ++counted->count;
+        }
+        else {
+            seen.insert(CountedWord{string(word), 1}, hash);
+            if (!m_dict->lookup(word)) {
+                misspelled.emplace_back(word);
+            }
+        }
+        word = fr.getWordView();
+    }
+    print_read_stats(num_words, seen.size(), out);
+    multikeySort(misspelled);
+    for (const auto& misspelled_word : misspelled) {
+        counts.push_back(seen.find(misspelled_word)->count);
+    }
+    return misspelled;
+}
+
+std::vector<string> App::find_misspelled_parallel(const MappedFile& file, std::ostream& out,
+    std::vector<size_t>& counts) {
+    file.adviseSequential();
+    ShardedReader reader(m_pool, file, std::min(m_pool.numThreads(), file.size() / PARALLEL_READ_CHUNK_BYTES));
+    size_t num_shards = reader.numShards();
+    using words_t = Hashtable<CountedWord, std::string_view>;
+
+    // Unique words of each chunk, by shard, merged by shard summing their
+    // counts and looking up those first seen
+    std::vector<std::vector<std::unique_ptr<words_t>>> chunks(reader.numChunks());
+    std::vector<size_t> num_words(reader.numChunks(), 0);
+    std::vector<size_t> num_unique_words(num_shards, 0);
+    std::vector<std::vector<string>> misspelled(num_shards);
+    std::vector<std::unique_ptr<words_t>> shards(num_shards);
+    reader.read([&](size_t i, FileReader& fr) {
+        for (size_t shard = 0; shard < num_shards; ++shard) {
+            chunks[i].push_back(std::make_unique<words_t>(m_hasher.func, CHECKED_FILE_WORDS_HINT / num_shards));
+        }
+        std::string_view word = fr.getWordView();
+        while (!word.empty()) {
+            ++num_words[i];
+            size_t hash = m_hasher.func(word);
+            words_t& seen = *chunks[i][reader.shardOf(hash)];
+            if (const CountedWord* counted = seen.find(word, hash)) {
+                ++counted->count;
+            }
+            else {
+                seen.insert(CountedWord{string(word), 1}, hash);
+            }
+            word = fr.getWordView();
+        }
+    }, [&](size_t shard) {
+        shards[shard] = std::make_unique<words_t>(m_hasher.func, CHECKED_FILE_WORDS_HINT / num_shards);
+        words_t& seen = *shards[shard];
+        for (auto& chunk : chunks) {
+            chunk[shard]->forEach([&](const CountedWord& chunk_word) {
+                size_t hash = m_hasher.func(chunk_word.word);
+                if (const CountedWord* counted = seen.find(chunk_word.word, hash)) {
+                    counted->count += chunk_word.count;
+                }
+                else {
+                    seen.insert(chunk_word, hash);
+                    if (!m_dict->lookup(chunk_word.word)) {
+                        misspelled[shard].push_back(chunk_word.word);
+                    }
+                }
+            });
+            // Release memory as we go
+            chunk[shard].reset();
+        }
+        num_unique_words[shard] = seen.size();
+    });
+
+    std::vector<string> res;
+    for (auto& words : misspelled) {
+        res.insert(res.end(), std::make_move_iterator(words.begin()), std::make_move_iterator(words.end()));
+    }
+    size_t total_words = 0, total_unique_words = 0;
+    for (size_t n : num_words) {
+        total_words += n;
+    }
+    for (size_t n : num_unique_words) {
+        total_unique_words += n;
+    }
+    print_read_stats(total_words, total_unique_words, out);
+    multikeySort(res);
+    for (const auto& word : res) {
+        size_t hash = m_hasher.func(word);
+        counts.push_back(shards[reader.shardOf(hash)]->find(word, hash)->count);
+    }
+    return res;
+}
+
+std::vector<string> App::find_misspelled_tree(FileReader& fr, std::ostream& out, std::vector<size_t>& counts) {
     std::shared_ptr<RBTree<string>> words_tree;
-    Hashtable<string> tree_filter(hash, HASH_TABLE_SIZE);
+    Hashtable<CountedWord, std::string_view> tree_filter(m_hasher.func, CHECKED_FILE_WORDS_HINT);
     words_tree = RBTree<string>::createTree(strings_cmp_callback);
-    FileReader fr(checked_path);
-    string word;
-    cout << "Reading input file..." << endl;
     size_t num_words = 0;
     size_t num_unique_words = 0;
-    word = fr.getWord();
-    while (word != "") {
+    std::string_view word = fr.getWordView();
+    while (!word.empty()) {
         ++num_words;
-        if (!tree_filter.lookup(word)) {
+        if (const CountedWord* counted = tree_filter.find(word)) {
+            ++counted->count;
+        }
+        else {
             ++num_unique_words;
-            tree_filter.insert(word);
-            words_tree->insert(word);
+            tree_filter.insert(CountedWord{string(word), 1});
+            words_tree->insert(string(word));
         }
-        word  = fr.getWord();
+        word  = fr.getWordView();
     }
-    cout << "Finished reading input file." << endl;
-    cout << "Words in input file: " << num_words << endl;
-    cout << "Unique words in input file: " << num_unique_words << endl;
-    cout << "Filtering words..." << endl;
+    print_read_stats(num_words, num_unique_words, out);
     auto it = words_tree->minimum();
     while (it && !it->isNil()) {
-        if (m_dict.lookup(it->get())) {
+        if (m_dict->lookup(it->get())) {
             it = it->kill();
         }
         else {
             it = it->succ();
         }
     }
-    cout << "The following words are not in the dictionary:" << endl;
-    it = words_tree->minimum();
-    while (it && !it->isNil()) {
-        word = it->get();
-        cout << word << endl;
-        auto suggestion = m_autocorrect.attemptAutocorrect(word);
-        if (suggestion != "") {
-            cout << "Did you mean: '" << suggestion << "'?" << endl;
+    std::vector<string> misspelled;
+    for (it = words_tree->minimum(); it && !it->isNil(); it = it->succ()) {
+        misspelled.push_back(it->get());
+        counts.push_back(tree_filter.find(it->get())->count);
+    }
+    return misspelled;
+}
+
+void App::print_read_stats(size_t num_words, size_t num_unique_words, std::ostream& out) const {
+    out << "Finished reading input file.\n";
+    out << "Words in input file: " << num_words << '\n';
+    out << "Unique words in input file: " << num_unique_words << '\n';
+    out << "Filtering words...\n";
+}
+
+void App::writeIndex(string index_path) const {
+    if (m_config.use_word_graph) {
+        m_writer.progress() << "Writing word graph...\n";
+        const WordGraph* graph = dynamic_cast<const WordGraph*>(m_dict.get());
+        if (graph) {
+            graph->write(index_path);
+        }
+        else {
+            WordGraph(*m_dict, m_num_words_in_dict_file).write(index_path);
         }
-        it = it->succ();
+        m_writer.progress() << "Finished writing word graph to '" << index_path << "'.\n";
+        return;
     }
-    
+    m_writer.progress() << "Writing dictionary index...\n";
+    DictionaryIndex::write(*m_dict, m_num_words_in_dict_file, m_hasher, index_path);
+    m_writer.progress() << "Finished writing dictionary index to '" << index_path << "'.\n";
 }
 
-void App::read_dict(string dict_path) {
-    size_t num_words_in_dict = 0;
-    size_t num_words_in_dict_file = 0;
-    FileReader fr(dict_path);
-    cout << "Reading dictionaty..." << endl;
-    string word = fr.getWord();
-    while (word != "") {
-        try {
-            ++num_words_in_dict_file;
-            m_dict.insert(word);
-            ++num_words_in_dict;
-        }
-        // Some words are double in lower/upper case,
-        // or they are the same as another word with non-alphanumeric characters in it.
-        catch (const KeyAlreadyExists& e) {}
-        word  = fr.getWord();
-    }
-    cout << "Finished loading dictionary:" << endl;
-    cout << "Words in dictionary file: " << num_words_in_dict_file << endl;
-    cout << "Unique words in dictionary: " << num_words_in_dict << endl;
+std::unique_ptr<Dictionary> App::load_dict(string dict_path) {
+    std::unique_ptr<Dictionary> dict;
+    if (WordGraph::isGraph(dict_path)) {
+        dict = read_graph(dict_path);
+    }
+    else {
+        dict = DictionaryIndex::isIndex(dict_path) ? read_index(dict_path) : read_dict(dict_path);
+        if (m_config.use_word_graph) {
+            dict = to_graph(std::move(dict));
+        }
+    }
+    if (m_config.partition_by_length) {
+        dict = to_length_partitions(std::move(dict));
+    }
+    if (m_config.bloom_false_positive_rate <= 0) {
+        return dict;
+    }
+    auto filtered = std::make_unique<FilteredDictionary>(std::move(dict), m_hasher.func, m_config.bloom_false_positive_rate);
+    const BloomFilter& filter = filtered->filter();
+    m_writer.progress() << "Bloom filter: " << filter.sizeBytes() / 1024 << " KB, "
+        << filter.sizeBytes() * 8 / std::max<size_t>(filtered->size(), 1) << " bits per word, "
+        << filter.numHashes() << " hash functions, estimated false positive rate "
+        << filter.estimatedFalsePositiveRate() * 100 << "%\n";
+    return filtered;
+}
+
+std::unique_ptr<LruCache<string, string>> App::load_cache() const {
+    if (m_config.cache_size == 0 && m_config.cache_path.empty()) {
+        return nullptr;
+    }
+    auto cache = std::make_unique<LruCache<string, string>>(
+        m_config.cache_size > 0 ? m_config.cache_size : DEFAULT_CACHE_SIZE);
+    std::ifstream in(m_config.cache_path);
+    string line;
+    if (m_config.cache_path.empty() || !std::getline(in, line)) {
+        return cache;
+    }
+    if (line != cache_header()) {
+        m_writer.progress() << "Ignoring suggestion cache '" << m_config.cache_path
+            << "' of another dictionary or suggestion engine.\n";
+        return cache;
+    }
+    while (std::getline(in, line)) {
+        size_t tab = line.find('\t');
+        if (tab == string::npos) {
+            throw FileError("Corrupted suggestion cache '" + m_config.cache_path + "'");
+        }
+        cache->put(line.substr(0, tab), line.substr(tab + 1));
+    }
+    m_writer.progress() << "Loaded " << cache->size() << " cached suggestions.\n";
+    return cache;
+}
+
+void App::saveCache() const {
+    if (!m_cache || m_config.cache_path.empty()) {
+        return;
+    }
+    // Write a new file and rename it over the old one, so an interrupted
+    // save does not corrupt the cache
+    string tmp_path = m_config.cache_path + ".tmp";
+    std::ofstream out(tmp_path, std::ios::trunc);
+    out << cache_header() << '\n';
+    m_cache->forEach([&](const string& word, const string& suggestion) {
+        out << word << '\t' << suggestion << '\n';
+    });
+    out.close();
+    if (!out || std::rename(tmp_path.c_str(), m_config.cache_path.c_str()) != 0) {
+        throw FileError("Cannot write suggestion cache to '" + m_config.cache_path + "'");
+    }
+}
+
+uint64_t App::dict_fingerprint() const {
+    // A sum does not depend on the order of the words, which differs
+    // between backends and builds
+    uint64_t fingerprint = 0;
+    m_dict->forEachWord([&](const string& word) {
+        fingerprint += wyhash(word);
+    });
+    return fingerprint;
+}
+
+string App::cache_header() const {
+    return "SPLCHCACHE 3 " + std::to_string(m_num_words_in_dict_file) + " " + std::to_string(m_dict->size())
+        + " " + std::to_string(m_dict_fingerprint)
+        + " " + (m_fallback ? m_config.fallback_engine + " " + std::to_string(m_fallback->maxDistance()) : "-")
+        + (ranked() ? " top " + std::to_string(m_config.top_suggestions)
+            + " " + std::to_string(m_frequencies ? m_frequencies->size() : 0)
+            + " " + std::to_string(m_config.max_probes) + " " + std::to_string(m_config.max_suggest_us) : "");
+}
+
+std::unique_ptr<Suggester> App::load_fallback() const {
+    if (m_config.fallback_engine == "symspell") {
+        m_writer.progress() << "Building deletion index...\n";
+        auto index = std::make_unique<DeletionIndex>(*m_dict, m_hasher.func, m_config.fallback_distance,
+            m_config.deletion_memory_mb << 20);
+        m_writer.progress() << "Deletion index: " << index->sizeBytes() / (1024*1024) << " MB, distance "
+            << index->maxDistance() << ", prefix length " << index->prefixLength() << '\n';
+        return index;
+    }
+    if (m_config.fallback_engine == "trie") {
+        m_writer.progress() << "Building trie...\n";
+        auto trie = std::make_unique<Trie>(*m_dict, m_config.fallback_distance);
+        m_writer.progress() << "Trie: " << trie->numNodes() << " nodes, " << trie->sizeBytes() / (1024*1024) << " MB, distance "
+            << trie->maxDistance() << '\n';
+        return trie;
+    }
+    return nullptr;
+}
+
+std::unique_ptr<FrequencyTable> App::load_frequencies() const {
+    if (m_config.frequency_path.empty()) {
+        return nullptr;
+    }
+    m_writer.progress() << "Reading word frequencies...\n";
+    auto frequencies = std::make_unique<FrequencyTable>(m_hasher.func, m_config.frequency_path);
+    m_writer.progress() << "Word frequencies: " << frequencies->size() << " words\n";
+    return frequencies;
+}
+
+std::unique_ptr<Dictionary> App::read_dict(string dict_path) {
+    DictionaryBuilder builder(m_hasher.func, m_config.threads);
+    m_writer.progress() << "Reading dictionaty...\n";
+    auto dict = builder.build(dict_path);
+    m_num_words_in_dict_file = builder.numWordsInFile();
+    m_writer.progress() << "Finished loading dictionary:\n";
+    m_writer.progress() << "Words in dictionary file: " << m_num_words_in_dict_file << '\n';
+    m_writer.progress() << "Unique words in dictionary: " << dict->size() << '\n';
+    return dict;
+}
+
+std::unique_ptr<Dictionary> App::read_index(string index_path) {
+    m_writer.progress() << "Mapping dictionary index...\n";
+    auto dict = std::make_unique<DictionaryIndex>(index_path);
+    m_num_words_in_dict_file = dict->numWordsInFile();
+    m_writer.progress() << "Finished loading dictionary:\n";
+    m_writer.progress() << "Words in dictionary file: " << m_num_words_in_dict_file << '\n';
+    m_writer.progress() << "Unique words in dictionary: " << dict->size() << '\n';
+    return dict;
+}
+
+std::unique_ptr<Dictionary> App::read_graph(string graph_path) {
+    m_writer.progress() << "Mapping word graph...\n";
+    auto dict = std::make_unique<WordGraph>(graph_path);
+    m_num_words_in_dict_file = dict->numWordsInFile();
+    m_writer.progress() << "Finished loading dictionary:\n";
+    m_writer.progress() << "Words in dictionary file: " << m_num_words_in_dict_file << '\n';
+    m_writer.progress() << "Unique words in dictionary: " << dict->size() << '\n';
+    m_writer.progress() << "Word graph: " << dict->numEdges() << " edges, " << dict->sizeBytes() / 1024 << " KB\n";
+    return dict;
+}
+
+std::unique_ptr<Dictionary> App::to_graph(std::unique_ptr<Dictionary> dict) const {
+    m_writer.progress() << "Building word graph...\n";
+    auto graph = std::make_unique<WordGraph>(*dict, m_num_words_in_dict_file);
+    m_writer.progress() << "Word graph: " << graph->numEdges() << " edges, " << graph->sizeBytes() / 1024 << " KB\n";
+    return graph;
+}
+
+std::unique_ptr<Dictionary> App::to_length_partitions(std::unique_ptr<Dictionary> dict) const {
+    m_writer.progress() << "Partitioning dictionary by length...\n";
+    auto partitioned = std::make_unique<LengthDictionary>(*dict, m_hasher.func);
+    m_writer.progress() << "Length partitions: " << partitioned->numPartitions() << " lengths, "
+        << partitioned->sizeBytes() / 1024 << " KB\n";
+    return partitioned;
 }
@@ -2,25 +2,180 @@
 #ifndef APP_H
 #define APP_H
 
+#include <memory>
+#include <mutex>
+#include <ostream>
 #include <string>
+#include <vector>
 
 #include "Autocorrect.h"
+#include "Config.h"
+#include "Suggester.h"
+#include "Dictionary.h"
+#include "FileReader.h"
+#include "FrequencyTable.h"
 #include "Hashtable.h"
+#include "LruCache.h"
+#include "MappedFile.h"
 #include "RBTree.h"
+#include "ReportWriter.h"
+#include "Socket.h"
+#include "ThreadPool.h"
 
 class App final {
 public:
-	App(std::string dict_path);
+	// Loads the dictionary at dict_path, either a text file or an index
+	// written by writeIndex
+	App(std::string dict_path, const Config& config);
 	~App();
 
-	void run(std::string checked_path);
+	// Checks the files at checked_paths, reporting each in order. With
+	// several jobs configured, that many files are checked at a time, each
+	// on a single thread, and each report is buffered until the reports of
+	// the files before it are written
+	void run(const std::vector<std::string>& checked_paths);
+
+	// Checks the words of a file as they are read (e.g. from a pipe),
+	// writing each misspelled word with its suggestions when first seen.
+	// Only the last words seen, up to the configured cap, are remembered,
+	// so a word forgotten since is reported again
+	void stream(const std::string& checked_path);
+
+	// Serves requests of clients connecting to a Unix domain socket at
+	// socket_path until SIGINT or SIGTERM, returning once the requests being
+	// answered are done. Requests are answered on a pool of the
+	// configured number of threads, one request at a time on each (others
+	// wait), while idle clients hold no thread.
+	// A request is a command, a space and a text:
+	//   "check <text>": the unique misspelled words of the text, in order of
+	//     first appearance
+	//   "suggest <text>": every unique word of the text
+	// The response is a status ("ok" or "error") and the microseconds the
+	// server spent on the request, on a line, followed by a line per word:
+	// the word and its suggestions, tab separated (or an error message,
+	// e.g. for a response longer than the largest message)
+	void serve(const std::string& socket_path);
+
+	// Writes a precompiled index (or word graph, if configured) of the
+	// dictionary, to be loaded instead of the text file on later runs
+	void writeIndex(std::string index_path) const;
+
+	// Saves the suggestion cache to the cache file, if configured
+	void saveCache() const;
 
 private:
-	void read_dict(std::string dict_path);
+	// Loads the dictionary from a text or index file, fronted by a Bloom
+	// filter if configured
+	std::unique_ptr<Dictionary> load_dict(std::string dict_path);
+	std::unique_ptr<Dictionary> read_dict(std::string dict_path);
+	std::unique_ptr<Dictionary> read_index(std::string index_path);
+	std::unique_ptr<Dictionary> read_graph(std::string graph_path);
+
+	// Builds a word graph of a dictionary, which it replaces
+	std::unique_ptr<Dictionary> to_graph(std::unique_ptr<Dictionary> dict) const;
+
+	// Partitions a dictionary by word length, replacing it
+	std::unique_ptr<Dictionary> to_length_partitions(std::unique_ptr<Dictionary> dict) const;
+
+	// Builds the fallback suggestion engine, if configured
+	std::unique_ptr<Suggester> load_fallback() const;
+
+	// Suggestions for a misspelled word, best first
+	using suggestions_t = std::vector<ReportWriter::Suggestion>;
+
+	// A checked file's misspelled words and their suggestions
+	struct Report;
+
+	// Reads a checked file, writing its progress to out, and finds its
+	// misspelled words and suggestions for those not cached: either on
+	// the thread pool, or on the given thread only (indexing m_autocorrects)
+	void check(const std::string& checked_path, std::ostream& out, Report& report, size_t thread, bool use_pool);
+
+	// Completes the suggestions of a checked file from the cache, updating
+	// the cache in order of the words as when suggesting for one word at a
+	// time, and writes them. Words evicted since they were checked are
+	// suggested for on the given thread
+	void finish(Report& report, size_t thread);
+
+	// Suggestions for a misspelled word from the cache, if cached.
+	// Otherwise the given suggestions (or, if none, those made by
+	// autocorrect), which are then cached. Requires the cache, and the
+	// caller to hold m_cache_mutex when other threads may use it
+	suggestions_t suggest_cached(const std::string& word, suggestions_t* suggested, Autocorrect& autocorrect);
+
+	// Answers the next request of a client. False if it disconnected,
+	// stalled or broke the protocol, so it should be dropped. An error
+	// handling the request is sent to the client rather than thrown
+	bool serve_request(const Socket& client, Autocorrect& autocorrect);
+
+	// Body of the response to a request of a client (see serve()). Throws
+	// InvalidOption for an unknown command
+	std::string respond(std::string_view request, Autocorrect& autocorrect);
+
+	// Suggestions for a misspelled word from the cache if enabled, made by
+	// autocorrect outside the cache lock (so clients do not wait for each
+	// other's suggestions) and then cached
+	suggestions_t suggest_shared(Autocorrect& autocorrect, const std::string& word);
+
+	// Unique words of a checked file that are not in the dictionary, in
+	// lexicographic order, adding the number of occurrences of each to
+	// counts. Either checks each word once, when first seen, or collects all
+	// words in a red-black tree and then kills the known ones
+	std::vector<std::string> find_misspelled(FileReader& fr, std::ostream& out, std::vector<size_t>& counts);
+	std::vector<std::string> find_misspelled_tree(FileReader& fr, std::ostream& out, std::vector<size_t>& counts);
+
+	// find_misspelled of a large mapped file on the thread pool, by a
+	// ShardedReader: each thread collects the unique words of a chunk, split
+	// into shards by hash. Then each thread merges a shard of all chunks and
+	// looks up the words first seen
+	std::vector<std::string> find_misspelled_parallel(const MappedFile& file, std::ostream& out,
+		std::vector<size_t>& counts);
+
+	// Suggestions for a misspelled word by an autocorrect. Ranked if
+	// configured, otherwise the first word the edit strategies find
+	suggestions_t suggest(Autocorrect& autocorrect, const std::string& word) const;
+
+	// An autocorrect per thread of the pool or per job, as each keeps its
+	// own buffers
+	std::vector<Autocorrect> make_autocorrects() const;
+
+	// Whether suggestions are ranked by suggest(), rather than the first
+	// found only
+	bool ranked() const;
+
+	// Reads the word frequencies file, if configured
+	std::unique_ptr<FrequencyTable> load_frequencies() const;
+
+	// Creates the suggestion cache if enabled, loading the cache file if
+	// configured and it exists
+	std::unique_ptr<LruCache<std::string, std::string>> load_cache() const;
+
+	// Order independent hash of the words of the dictionary
+	uint64_t dict_fingerprint() const;
+
+	// First line of cache files, identifying the dictionary, fallback
+	// engine and ranking the cached suggestions were made with
+	std::string cache_header() const;
+
+	// Reports the words read from a checked file
+	void print_read_stats(size_t num_words, size_t num_unique_words, std::ostream& out) const;
 
 	bool m_suggestions;
-	Hashtable<std::string> m_dict;
-	Autocorrect m_autocorrect;
+	Config m_config;
+	// Constructed before the members whose loading writes progress
+	ReportWriter m_writer;
+	const Hasher& m_hasher;
+	size_t m_num_words_in_dict_file;
+	std::unique_ptr<Dictionary> m_dict;
+	// Identifies the dictionary in the cache file, when there is one
+	uint64_t m_dict_fingerprint;
+	std::unique_ptr<Suggester> m_fallback;
+	std::unique_ptr<FrequencyTable> m_frequencies;
+	ThreadPool m_pool;
+	std::vector<Autocorrect> m_autocorrects;
+	std::unique_ptr<LruCache<std::string, std::string>> m_cache;
+	// Guards m_cache while checking several files at a time
+	std::mutex m_cache_mutex;
 };
 
 #endif
@@ -1,12 +1,13 @@
 
-#include <list>
+#include <algorithm>
+#include <array>
 #include <string>
 #include <tuple>
 #include <utility>
 
 #include "Autocorrect.h"
 
-using std::string, std::tuple, std::tie, std::list;
+using std::string, std::string_view, std::tuple;
 
 constexpr tuple<char,char> homophones[] = {
 	{'a', 'e'},
@@ -28,89 +29,157 @@ constexpr tuple<char,char> homophones[] = {
 	{'x', 'z'}
 };
 
-static list<string> findHomophonicWordsBy(string word, char a, char b) {
-	list<string> results;
-	size_t idx = word.find(a);
-	while (idx != string::npos) {
-		results.push_back(word.substr(0, idx) + b + word.substr(idx+1, string::npos));
-		idx = word.find(a, idx+1);
+// Most homophones of a single letter
+constexpr size_t MAX_HOMOPHONES = 4;
+
+// The homophones a letter may be switched to, and the rank of each switch:
+// switches are tried by pair in homophones, then by direction
+struct Homophones final {
+	size_t count;
+	char letters[MAX_HOMOPHONES];
+	size_t ranks[MAX_HOMOPHONES];
+};
+
+// The homophones of each letter, built from homophones at compile time
+constexpr std::array<Homophones, 256> makeHomophoneTable() {
+	std::array<Homophones, 256> table{};
+	size_t rank = 0;
+	for (const auto& pair : homophones) {
+		for (int dir = 0; dir < 2; ++dir) {
+			char from = dir == 0 ? std::get<0>(pair) : std::get<1>(pair);
+			char to = dir == 0 ? std::get<1>(pair) : std::get<0>(pair);
+			Homophones& entry = table[static_cast<unsigned char>(from)];
+			entry.letters[entry.count] = to;
+			entry.ranks[entry.count] = rank++;
+			++entry.count;
+		}
 	}
-	return results;
+	return table;
 }
 
+constexpr std::array<Homophones, 256> homophone_table = makeHomophoneTable();
 
-string Autocorrect::findLetterDoubledWords(string word) {
-	for (size_t i = 0; i < word.length()-1; ++i) {
-		if (word[i] == word[i+1]) {
-			string mod_word = word.substr(0, i) + word.substr(i+1, string::npos);
-			if (m_dict.lookup(mod_word)) {
-				return mod_word;
-			}
+static_assert([] {
+	for (const auto& entry : homophone_table) {
+		if (entry.count > MAX_HOMOPHONES) {
+			return false;
 		}
 	}
-	return "";
+	return true;
+}(), "A letter has more than MAX_HOMOPHONES homophones");
+
+bool Autocorrect::addCandidate() {
+	m_batch_chars += m_edit;
+	m_batch_ends.push_back(m_batch_chars.length());
+	return m_batch_ends.size() == Dictionary::MAX_BATCH;
 }
 
-string Autocorrect::findDoubledroppedWords(string word) {
-	for (size_t i = 0; i < word.length(); ++i) {
-		string mod_word = word.substr(0, i) + word[i] + word.substr(i, string::npos);
-		if (m_dict.lookup(mod_word)) {
-			return mod_word;
+// m_edit is left as is between the calls of a strategy on a word, so each
+// call resumes the edits where the previous one stopped
+
+bool Autocorrect::addLetterDoubledWords(string_view word) {
+	// Candidate i is word without letter i. Starting from candidate 0,
+	// candidate i+1 differs from candidate i only by letter i
+	if (m_next == 0) {
+		m_edit.assign(word.substr(1));
+	}
+	for (size_t i = m_next; i < word.length()-1; ++i) {
+		if (i > 0) {
+			m_edit[i-1] = word[i-1];
+		}
+		if (word[i] == word[i+1] && addCandidate()) {
+			m_next = i + 1;
+			return true;
 		}
 	}
-	return "";
+	return false;
 }
 
-string Autocorrect::findHomophonicWords(string word) {
-	for (auto t : homophones) {
-		char a, b;
-		tie(a, b) = t;
-		for (auto mod_word : findHomophonicWordsBy(word, a, b)) {
-			if (m_dict.lookup(mod_word)) {
-				return mod_word;
-			}
+bool Autocorrect::addDoubledroppedWords(string_view word) {
+	// Candidate i is word with letter i written twice. Starting from
+	// candidate 0, candidate i+1 differs from candidate i only at i+1
+	if (m_next == 0) {
+		m_edit.assign(1, word[0]);
+		m_edit.append(word);
+	}
+	for (size_t i = m_next; i < word.length(); ++i) {
+		if (i > 0) {
+			m_edit[i] = word[i];
+		}
+		if (addCandidate()) {
+			m_next = i + 1;
+			return true;
 		}
-		std::swap(a, b);
-		for (auto mod_word : findHomophonicWordsBy(word, a, b)) {
-			if (m_dict.lookup(mod_word)) {
-				return mod_word;
+	}
+	return false;
+}
+
+bool Autocorrect::addHomophonicWords(string_view word) {
+	// A single pass finds all switches, keyed by (rank, position, letter).
+	// Adding them in key order tries each pair and direction in turn, each
+	// from the start of the word
+	if (m_next == 0) {
+		m_swaps.clear();
+		for (size_t idx = 0; idx < word.length(); ++idx) {
+			const Homophones& entry = homophone_table[static_cast<unsigned char>(word[idx])];
+			for (size_t i = 0; i < entry.count; ++i) {
+				m_swaps.push_back(static_cast<uint64_t>(entry.ranks[i]) << 56 | static_cast<uint64_t>(idx) << 8
+					| static_cast<unsigned char>(entry.letters[i]));
 			}
 		}
+		std::sort(m_swaps.begin(), m_swaps.end());
+		m_edit.assign(word);
 	}
-	return "";
+	for (size_t i = m_next; i < m_swaps.size(); ++i) {
+		size_t idx = (m_swaps[i] >> 8) & ((uint64_t(1) << 48) - 1);
+		m_edit[idx] = static_cast<char>(m_swaps[i] & 0xff);
+		bool full = addCandidate();
+		m_edit[idx] = word[idx];
+		if (full) {
+			m_next = i + 1;
+			return true;
+		}
+	}
+	return false;
 }
 
-string Autocorrect::findSwapLetteredWords(string word) {
-	for (size_t i = 0; i < word.length()-1; ++i) {
-		string mod_word = word.substr(0, i) + word[i+1] + word[i] + word.substr(i+2, string::npos);
-		if (m_dict.lookup(mod_word)) {
-			return mod_word;
+bool Autocorrect::addSwapLetteredWords(string_view word) {
+	if (m_next == 0) {
+		m_edit.assign(word);
+	}
+	for (size_t i = m_next; i < word.length()-1; ++i) {
+		std::swap(m_edit[i], m_edit[i+1]);
+		bool full = addCandidate();
+		std::swap(m_edit[i], m_edit[i+1]);
+		if (full) {
+			m_next = i + 1;
+			return true;
 		}
 	}
-	return "";
+	return false;
 }
 
-Autocorrect::Autocorrect(const Hashtable<string>& dict)
-	: m_dict(dict) {}
+Autocorrect::Autocorrect(const Dictionary& dict, const Suggester* fallback, const FrequencyTable* frequencies)
+	: m_dict(dict)
+	, m_fallback(fallback)
+	, m_frequencies(frequencies) {}
 
 Autocorrect::~Autocorrect() {}
 
-string Autocorrect::attemptAutocorrect(string word) {
-	auto res = findLetterDoubledWords(word);
-	if (res != "") {
-		return res;
-	}
-	res = findSwapLetteredWords(word);
-	if (res != "") {
-		return res;
-	}
-	res = findDoubledroppedWords(word);
-	if (res != "") {
-		return res;
-	}
-	res = findHomophonicWords(word);
-	if (res != "") {
-		return res;
+string Autocorrect::attemptAutocorrect(string_view word, const char** strategy) {
+	return attemptWith(word, DefaultPipeline{}, strategy);
+}
+
+std::vector<Autocorrect::Suggestion> Autocorrect::suggest(string_view word, size_t k, const Budget& budget) {
+	return suggestWith(word, k, budget, DefaultPipeline{});
+}
+
+string Autocorrect::fallbackSuggestion(string_view word) const {
+	if (m_fallback) {
+		auto matches = m_fallback->find(word, m_fallback->maxDistance());
+		if (!matches.empty()) {
+			return matches.front().word;
+		}
 	}
 	return "";
 }
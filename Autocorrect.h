@@ -2,34 +2,129 @@
 #ifndef AUTOCORRECT_H
 #define AUTOCORRECT_H
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
-#include "Hashtable.h"
+#include "Dictionary.h"
+#include "FrequencyTable.h"
+#include "Suggester.h"
 
 class Autocorrect final {
 public:
-	Autocorrect(const Hashtable<std::string>& dict);
+	// A ranked suggestion
+	struct Suggestion final {
+		std::string word;
+		// Frequency of the word in the frequency table, 0 if none
+		uint64_t frequency;
+		// Name of the strategy which found the word
+		const char* strategy;
+	};
+
+	// Bounds on the work of a suggest() call, 0 for unbounded
+	struct Budget final {
+		// Number of candidates looked up in the dictionary
+		size_t max_probes = 0;
+		std::chrono::microseconds max_time{0};
+	};
+
+	// An edit strategy: edits the candidates it makes of a word in place in
+	// m_edit, adding each to the window of candidates, starting from
+	// candidate m_next (0 for the first call on a word). Returns true if it
+	// stopped as the window filled up, having set m_next to resume from on
+	// the next call, or false once all its candidates were added
+	using Strategy = bool (Autocorrect::*)(std::string_view word);
+
+	// Strategies tried in the given order, each order compiled to its own
+	// specialization of attemptWith and suggestWith, with the strategies
+	// inlined
+	template <Strategy... Strategies>
+	struct Pipeline final {};
+
+	// Suggests words of dict. If a fallback engine is given, it is searched
+	// for the closest words when none of the edit strategies match. If a
+	// frequency table is given, suggest() ranks words by it
+	Autocorrect(const Dictionary& dict, const Suggester* fallback = nullptr,
+		const FrequencyTable* frequencies = nullptr);
 	~Autocorrect();
 
-	// Try yo find a word that the author ment
-	std::string attemptAutocorrect(std::string word);
+	// Try yo find a word that the author ment. If strategy is given, it is
+	// set to the name of the strategy which found it
+	std::string attemptAutocorrect(std::string_view word, const char** strategy = nullptr);
+
+	// Up to k words the author may have meant, found by all strategies (and
+	// the fallback engine if none match), most frequent first. Ties are kept
+	// in strategy order, so without a frequency table the first suggestion
+	// is the one attemptAutocorrect returns. Stops looking up candidates
+	// when the budget runs out, ranking those found so far
+	std::vector<Suggestion> suggest(std::string_view word, size_t k, const Budget& budget);
+
+	// attemptAutocorrect and suggest, with the strategies of a pipeline
+	template <Strategy... Strategies>
+	std::string attemptWith(std::string_view word, Pipeline<Strategies...>, const char** strategy = nullptr);
+	template <Strategy... Strategies>
+	std::vector<Suggestion> suggestWith(std::string_view word, size_t k, const Budget& budget,
+		Pipeline<Strategies...>);
+
+	// The strategies
+
+	// Words with a single letter switched to a homophonoc letter
+	bool addHomophonicWords(std::string_view word);
+
+	// Words that are the same as given word, with one letter doubled
+	bool addLetterDoubledWords(std::string_view word);
+
+	// Words that are the same as given word, with a double letter collapsed
+	// to single
+	bool addDoubledroppedWords(std::string_view word);
+
+	// Words that are the same as given word, with 2 consequtive letters
+	// swaped
+	bool addSwapLetteredWords(std::string_view word);
+
+	// Name of a strategy, as reported in suggestions
+	static constexpr const char* strategyName(Strategy strategy);
+
+	// The strategies of attemptAutocorrect and suggest, by priority
+	using DefaultPipeline = Pipeline<&Autocorrect::addLetterDoubledWords, &Autocorrect::addSwapLetteredWords,
+		&Autocorrect::addDoubledroppedWords, &Autocorrect::addHomophonicWords>;
 
 private:
-	// Find words with a single letter switched to a homophonoc letter
-	std::string findHomophonicWords(std::string word);
+	// Passes the candidates of a strategy for word to
+	// on_window(candidates, count) a window of up to MAX_BATCH at a time,
+	// until it returns false. Each window's views are valid during the call
+	template <Strategy add_candidates, class OnWindow>
+	void forEachWindow(std::string_view word, OnWindow&& on_window);
+
+	// Adds the candidate in m_edit to the window. Returns whether the window
+	// is full
+	bool addCandidate();
 
-	// Find words that are the same as given word, with one letter doubled
-	std::string findLetterDoubledWords(std::string word);
+	// The closest word the fallback engine finds ("" if none or no engine)
+	std::string fallbackSuggestion(std::string_view word) const;
 
-	// Find words that are the same as given word, with a double letter
-	// collapsed to single
-	std::string findDoubledroppedWords(std::string word);
+	const Dictionary& m_dict;
+	const Suggester* m_fallback;
+	const FrequencyTable* m_frequencies;
 
-	// Find words that are the same as given word, with 2 consequtive
-	// letters swaped
-	std::string findSwapLetteredWords(std::string word);
+	// Candidate edit buffer, and the window of up to MAX_BATCH candidates
+	// not looked up yet: their letters back to back and the end of each.
+	// Reused across words so they are only reallocated for a word longer
+	// than all the previous ones
+	std::string m_edit;
+	std::string m_batch_chars;
+	std::vector<size_t> m_batch_ends;
 
-	const Hashtable<std::string>& m_dict;
+	// Candidate of the current strategy to resume from (see Strategy)
+	size_t m_next = 0;
+
+	// Homophone swaps of the current word, by rank then position
+	std::vector<uint64_t> m_swaps;
 };
 
+#include "Autocorrect.hpp"
+
 #endif
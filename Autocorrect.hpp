@@ -0,0 +1,166 @@
+
+#ifndef AUTOCORRECT_HPP
+#define AUTOCORRECT_HPP
+
+#include <algorithm>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+
+constexpr const char* Autocorrect::strategyName(Strategy strategy) {
+	if (strategy == &Autocorrect::addLetterDoubledWords) {
+		return "letter doubled";
+	}
+	if (strategy == &Autocorrect::addSwapLetteredWords) {
+		return "letters swapped";
+	}
+	if (strategy == &Autocorrect::addDoubledroppedWords) {
+		return "double dropped";
+	}
+	if (strategy == &Autocorrect::addHomophonicWords) {
+		return "homophone";
+	}
+	return "custom";
+}
+
+template <Autocorrect::Strategy add_candidates, class OnWindow>
+void Autocorrect::forEachWindow(std::string_view word, OnWindow&& on_window) {
+	m_next = 0;
+	for (bool more = true; more;) {
+		m_batch_chars.clear();
+		m_batch_ends.clear();
+		more = (this->*add_candidates)(word);
+		if (m_batch_ends.empty()) {
+			return;
+		}
+		std::string_view candidates[Dictionary::MAX_BATCH];
+		size_t begin = 0;
+		for (size_t i = 0; i < m_batch_ends.size(); ++i) {
+			candidates[i] = std::string_view(m_batch_chars).substr(begin, m_batch_ends[i] - begin);
+			begin = m_batch_ends[i];
+		}
+		if (!on_window(candidates, m_batch_ends.size())) {
+			return;
+		}
+	}
+}
+
+template <Autocorrect::Strategy... Strategies>
+std::string Autocorrect::attemptWith(std::string_view word, Pipeline<Strategies...>, const char** strategy) {
+	if (word.empty()) {
+		return "";
+	}
+	// The first candidate found, as when looking them up one by one
+	std::string found;
+	auto first_found = [&](const std::string_view* candidates, size_t count) {
+		if (uint64_t hits = m_dict.lookupMany(candidates, count)) {
+			found.assign(candidates[__builtin_ctzll(hits)]);
+			return false;
+		}
+		return true;
+	};
+	// Tries the strategies in order, up to the first that finds a word
+	const char* found_by = "fallback";
+	bool any = ((forEachWindow<Strategies>(word, first_found), !found.empty()
+		&& (found_by = strategyName(Strategies), true)) || ...);
+	if (strategy) {
+		*strategy = found_by;
+	}
+	return any ? found : fallbackSuggestion(word);
+}
+
+template <Autocorrect::Strategy... Strategies>
+std::vector<Autocorrect::Suggestion> Autocorrect::suggestWith(std::string_view word, size_t k,
+	const Budget& budget, Pipeline<Strategies...>) {
+	// A suggestion and its rank among the words found
+	struct Ranked final {
+		Suggestion suggestion;
+		size_t order;
+	};
+	auto better = [](const Ranked& a, const Ranked& b) {
+		if (a.suggestion.frequency != b.suggestion.frequency) {
+			return a.suggestion.frequency > b.suggestion.frequency;
+		}
+		return a.order < b.order;
+	};
+	// The k best words found so far, in a heap whose top is the worst, and
+	// every word offered so far, including those pushed out of the heap
+	std::vector<Ranked> best;
+	std::unordered_set<std::string> offered;
+	size_t num_found = 0;
+	auto offer = [&](std::string_view found, const char* strategy) {
+		if (!offered.emplace(found).second) {
+			// Found by an earlier candidate or strategy, which ranks first
+			return;
+		}
+		Ranked ranked{Suggestion{std::string(found), m_frequencies ? m_frequencies->frequency(found) : 0, strategy},
+			num_found++};
+		if (best.size() < k) {
+			best.push_back(std::move(ranked));
+			std::push_heap(best.begin(), best.end(), better);
+		}
+		else if (better(ranked, best.front())) {
+			std::pop_heap(best.begin(), best.end(), better);
+			best.back() = std::move(ranked);
+			std::push_heap(best.begin(), best.end(), better);
+		}
+	};
+
+	auto deadline = std::chrono::steady_clock::now() + budget.max_time;
+	size_t num_probes = 0;
+	auto exhausted = [&]() {
+		return (budget.max_probes > 0 && num_probes >= budget.max_probes)
+			|| (budget.max_time.count() > 0 && std::chrono::steady_clock::now() >= deadline);
+	};
+	// Looks up all the candidates of a strategy a window at a time, within
+	// the budget
+	auto probe = [&](auto strategy) {
+		constexpr Strategy add_candidates = decltype(strategy)::value;
+		forEachWindow<add_candidates>(word, [&](const std::string_view* candidates, size_t count) {
+			if (exhausted()) {
+				return false;
+			}
+			if (budget.max_probes > 0) {
+				count = std::min(count, budget.max_probes - num_probes);
+			}
+			num_probes += count;
+			for (uint64_t found = m_dict.lookupMany(candidates, count); found; found &= found - 1) {
+				offer(candidates[__builtin_ctzll(found)], strategyName(add_candidates));
+			}
+			return true;
+		});
+	};
+	if (k == 0 || word.empty()) {
+		return {};
+	}
+	(probe(std::integral_constant<Strategy, Strategies>{}), ...);
+
+	// A search cannot be interrupted, so with a time budget the fallback is
+	// searched at growing distances (each finding the words of the previous
+	// one again), and gives up between two searches. Matches come closest
+	// first, so once k are found a farther search cannot change the result,
+	// unless ranked by frequency
+	if (m_fallback && best.empty()) {
+		size_t first_distance = budget.max_time.count() > 0 ? 1 : m_fallback->maxDistance();
+		std::vector<Suggester::Match> matches;
+		for (size_t distance = first_distance; distance <= m_fallback->maxDistance() && !exhausted(); ++distance) {
+			matches = m_fallback->find(word, distance);
+			if (!m_frequencies && matches.size() >= k) {
+				break;
+			}
+		}
+		for (const auto& match : matches) {
+			offer(match.word, "fallback");
+		}
+	}
+
+	std::sort_heap(best.begin(), best.end(), better);
+	std::vector<Suggestion> res;
+	res.reserve(best.size());
+	for (auto& ranked : best) {
+		res.push_back(std::move(ranked.suggestion));
+	}
+	return res;
+}
+
+#endif
@@ -0,0 +1,453 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Autocorrect.h"
+#include "DeletionIndex.h"
+#include "DictionaryBuilder.h"
+#include "Exceptions.h"
+#include "FileReader.h"
+#include "FilteredDictionary.h"
+#include "Hashtable.h"
+#include "LengthDictionary.h"
+#include "RBTree.h"
+#include "StringSort.h"
+#include "Trie.h"
+#include "WordGraph.h"
+#include "hash.h"
+#include "normalize.h"
+
+/**
+ * Micro benchmarks of the building blocks of the spell checker.
+ * Usage: ./benchmark <section> [args...]
+ */
+
+using std::cout, std::endl, std::string, std::string_view, std::vector;
+
+// Milliseconds it takes to run func
+template <class F>
+static double timeMs(F func) {
+	auto start = std::chrono::steady_clock::now();
+	func();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// All words in a file, in order of appearance
+static vector<string> readWords(string path) {
+	vector<string> words;
+	FileReader fr(path);
+	for (string word = fr.getWord(); word != ""; word = fr.getWord()) {
+		words.push_back(word);
+	}
+	return words;
+}
+
+// Unique words of a list, in order of first appearance
+static vector<string> uniqueWords(const vector<string>& words) {
+	vector<string> res;
+	Hashtable<string, string_view> seen(wyhash, words.size());
+	for (const auto& word : words) {
+		if (!seen.lookup(word)) {
+			seen.insert(word);
+			res.push_back(word);
+		}
+	}
+	return res;
+}
+
+// Hashing throughput and distribution of each hasher over words
+static void benchHashersOn(string title, const vector<string>& words) {
+	vector<string> keys = uniqueWords(words);
+	size_t num_bytes = 0;
+	for (const auto& word : words) {
+		num_bytes += word.length();
+	}
+	size_t num_buckets = 1;
+	while (num_buckets < keys.size()) {
+		num_buckets <<= 1;
+	}
+	double n = keys.size(), m = num_buckets;
+	double expected_collisions = n - m * (1 - std::pow(1 - 1/m, n));
+
+	cout << title << ": " << words.size() << " words, " << keys.size() << " unique, "
+		<< num_buckets << " buckets (ideal hash collisions: " << std::lround(expected_collisions) << ")" << endl;
+	cout << std::setw(16) << "hasher" << std::setw(12) << "Mhash/s" << std::setw(10) << "MB/s"
+		<< std::setw(12) << "collisions" << std::setw(12) << "max bucket" << std::setw(12) << "avg probe" << endl;
+	for (const auto& hasher : availableHashers()) {
+		constexpr int ROUNDS = 20;
+		size_t sink = 0;
+		double ms = timeMs([&]() {
+			for (int r = 0; r < ROUNDS; ++r) {
+				for (const auto& word : words) {
+					sink += hasher.func(word);
+				}
+			}
+		});
+
+		vector<size_t> buckets(num_buckets, 0);
+		// Linear probing table at the same load, for the average probe length
+		vector<bool> used(num_buckets, false);
+		size_t probes = 0;
+		for (const auto& key : keys) {
+			size_t idx = hasher.func(key) & (num_buckets - 1);
+			++buckets[idx];
+			while (used[idx]) {
+				++probes;
+				idx = (idx + 1) & (num_buckets - 1);
+			}
+			used[idx] = true;
+			++probes;
+		}
+		size_t occupied = std::count_if(buckets.begin(), buckets.end(), [](size_t b) { return b > 0; });
+
+		cout << std::setw(16) << hasher.name << std::fixed << std::setprecision(1)
+			<< std::setw(12) << ROUNDS * words.size() / ms / 1000
+			<< std::setw(10) << ROUNDS * num_bytes / ms / 1000
+			<< std::setw(12) << keys.size() - occupied
+			<< std::setw(12) << *std::max_element(buckets.begin(), buckets.end())
+			<< std::setw(12) << std::setprecision(2) << probes / n
+			<< (sink == 42 ? " " : "") << endl;
+	}
+	cout << endl;
+}
+
+static void benchHashers(int argc, char** argv) {
+	if (argc < 1) {
+		throw InvalidOption("Usage: ./benchmark hash <dict> [files...]");
+	}
+	for (int i = 0; i < argc; ++i) {
+		benchHashersOn(argv[i], readWords(argv[i]));
+	}
+}
+
+// The normalization of FileReader before it was vectorized, for comparison
+static string legacyProcessWord(string str) {
+	str.erase(std::remove_if(str.begin(), str.end(),
+		[](char c) { return !std::isalpha(c); }), str.end());
+	std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+	return str;
+}
+
+// Normalization kernels throughput over the raw tokens of files
+static void benchNormalizers(int argc, char** argv) {
+	if (argc < 1) {
+		throw InvalidOption("Usage: ./benchmark normalize <files...>");
+	}
+	// Raw (whitespace separated) tokens of all files, stored back to back and
+	// padded for the kernels
+	string text;
+	for (int i = 0; i < argc; ++i) {
+		std::ifstream file(argv[i]);
+		std::stringstream contents;
+		contents << file.rdbuf();
+		text += contents.str() + "\n";
+	}
+	vector<string_view> tokens;
+	string token;
+	std::istringstream reader(text);
+	string tokens_buffer;
+	vector<size_t> offsets;
+	while (reader >> token) {
+		offsets.push_back(tokens_buffer.size());
+		tokens_buffer += token;
+	}
+	offsets.push_back(tokens_buffer.size());
+	tokens_buffer.resize(tokens_buffer.size() + NORMALIZE_PADDING);
+	for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+		tokens.emplace_back(tokens_buffer.data() + offsets[i], offsets[i+1] - offsets[i]);
+	}
+	size_t num_bytes = offsets.back();
+
+	cout << tokens.size() << " tokens, " << num_bytes << " bytes" << endl;
+	cout << std::setw(16) << "kernel" << std::setw(12) << "Mtoken/s" << std::setw(10) << "MB/s" << endl;
+	constexpr int ROUNDS = 20;
+	auto report = [&](string name, double ms) {
+		cout << std::setw(16) << name << std::fixed << std::setprecision(1)
+			<< std::setw(12) << ROUNDS * tokens.size() / ms / 1000
+			<< std::setw(10) << ROUNDS * num_bytes / ms / 1000 << endl;
+	};
+	size_t sink = 0;
+	report("legacy", timeMs([&]() {
+		for (int r = 0; r < ROUNDS; ++r) {
+			for (auto tok : tokens) {
+				sink += legacyProcessWord(string(tok)).length();
+			}
+		}
+	}));
+	string out(tokens_buffer.size(), '\0');
+	for (const auto& normalizer : availableNormalizers()) {
+		report(normalizer.name, timeMs([&]() {
+			for (int r = 0; r < ROUNDS; ++r) {
+				for (auto tok : tokens) {
+					sink += normalizer.func(tok.data(), tok.length(), out.data());
+				}
+			}
+		}));
+	}
+	if (sink == 42) {
+		cout << endl;
+	}
+}
+
+// Red-black tree insert, in-order iteration and delete throughput
+static void benchRBTree(int argc, char** argv) {
+	if (argc < 1) {
+		throw InvalidOption("Usage: ./benchmark rbtree <files...>");
+	}
+	vector<string> words;
+	for (int i = 0; i < argc; ++i) {
+		vector<string> file_words = readWords(argv[i]);
+		words.insert(words.end(), file_words.begin(), file_words.end());
+	}
+	words = uniqueWords(words);
+	std::shuffle(words.begin(), words.end(), std::mt19937(15));
+	cout << words.size() << " keys" << endl;
+
+	constexpr int ROUNDS = 3;
+	double insert_ms = 0, iterate_ms = 0, delete_ms = 0;
+	size_t sink = 0;
+	for (int r = 0; r < ROUNDS; ++r) {
+		auto tree = RBTree<string>::createTree([](const string& a, const string& b) {
+			return a.compare(b);
+		});
+		insert_ms += timeMs([&]() {
+			for (const auto& word : words) {
+				tree->insert(word);
+			}
+		});
+		iterate_ms += timeMs([&]() {
+			for (auto it = tree->minimum(); it && !it->isNil(); it = it->succ()) {
+				sink += it->get().length();
+			}
+		});
+		// Delete every other key while iterating, as App does when filtering
+		// out known words, then the rest
+		delete_ms += timeMs([&]() {
+			for (int pass = 0; pass < 2; ++pass) {
+				bool kill = true;
+				auto it = tree->minimum();
+				while (it && !it->isNil()) {
+					it = kill ? it->kill() : it->succ();
+					kill = !kill || pass == 1;
+				}
+			}
+		});
+		if (!tree->minimum()->isNil()) {
+			throw std::runtime_error("Tree is not empty after deleting all keys");
+		}
+	}
+	auto report = [&](string name, double ms) {
+		cout << std::setw(10) << name << std::fixed << std::setprecision(2)
+			<< std::setw(10) << ROUNDS * words.size() / ms / 1000 << " Mkeys/s" << endl;
+	};
+	report("insert", insert_ms);
+	report("iterate", iterate_ms);
+	report("delete", delete_ms);
+	if (sink == 42) {
+		cout << endl;
+	}
+}
+
+// Sorting throughput of multikey quicksort against std::sort
+static void benchSort(int argc, char** argv) {
+	if (argc < 1) {
+		throw InvalidOption("Usage: ./benchmark sort <files...>");
+	}
+	vector<string> words;
+	for (int i = 0; i < argc; ++i) {
+		vector<string> file_words = readWords(argv[i]);
+		words.insert(words.end(), file_words.begin(), file_words.end());
+	}
+	words = uniqueWords(words);
+	std::shuffle(words.begin(), words.end(), std::mt19937(15));
+	cout << words.size() << " keys" << endl;
+
+	constexpr int ROUNDS = 3;
+	vector<string> expected;
+	auto bench = [&](string name, std::function<void(vector<string>&)> sort_func) {
+		double ms = 0;
+		for (int r = 0; r < ROUNDS; ++r) {
+			vector<string> sorted = words;
+			ms += timeMs([&]() { sort_func(sorted); });
+			if (expected.empty()) {
+				expected = sorted;
+			}
+			else if (sorted != expected) {
+				throw std::runtime_error(name + " sorted differently");
+			}
+		}
+		cout << std::setw(10) << name << std::fixed << std::setprecision(2)
+			<< std::setw(10) << ROUNDS * words.size() / ms / 1000 << " Mkeys/s" << endl;
+	};
+	bench("std::sort", [](vector<string>& strs) { std::sort(strs.begin(), strs.end()); });
+	bench("multikey", [](vector<string>& strs) { multikeySort(strs); });
+}
+
+// Dictionary lookups one at a time and in batches, of the words of files and
+// of candidates made from them by dropping a letter (mostly misses)
+static void benchLookup(int argc, char** argv) {
+	if (argc < 2) {
+		throw InvalidOption("Usage: ./benchmark lookup <dict-file> <files...>");
+	}
+	vector<string> queries;
+	for (int i = 1; i < argc; ++i) {
+		for (const auto& word : uniqueWords(readWords(argv[i]))) {
+			queries.push_back(word);
+			for (size_t j = 0; j < word.length(); ++j) {
+				queries.push_back(word.substr(0, j) + word.substr(j + 1));
+			}
+		}
+	}
+	std::shuffle(queries.begin(), queries.end(), std::mt19937(15));
+	vector<string_view> views(queries.begin(), queries.end());
+	cout << views.size() << " queries" << endl;
+
+	auto bench = [&](string name, const Dictionary& dict) {
+		constexpr int ROUNDS = 5;
+		size_t found_single = 0, found_batch = 0;
+		double single_ms = timeMs([&]() {
+			for (int r = 0; r < ROUNDS; ++r) {
+				for (auto view : views) {
+					found_single += dict.lookup(view);
+				}
+			}
+		});
+		double batch_ms = timeMs([&]() {
+			for (int r = 0; r < ROUNDS; ++r) {
+				for (size_t i = 0; i < views.size(); i += Dictionary::MAX_BATCH) {
+					size_t count = std::min(views.size() - i, Dictionary::MAX_BATCH);
+					found_batch += __builtin_popcountll(dict.lookupMany(&views[i], count));
+				}
+			}
+		});
+		if (found_single != found_batch) {
+			throw std::runtime_error(name + ": batched lookups found different words");
+		}
+		cout << std::setw(10) << name << std::fixed << std::setprecision(2)
+			<< std::setw(10) << ROUNDS * views.size() / single_ms / 1000 << " Mlookups/s single"
+			<< std::setw(10) << ROUNDS * views.size() / batch_ms / 1000 << " Mlookups/s batched" << endl;
+	};
+	DictionaryBuilder builder(wyhash, 1);
+	bench("hash", *builder.build(argv[0]));
+	bench("bloom", FilteredDictionary(builder.build(argv[0]), wyhash, 0.01));
+	bench("by-length", LengthDictionary(*builder.build(argv[0]), wyhash));
+	bench("dawg", WordGraph(*builder.build(argv[0]), 0));
+}
+
+// Misspelled words listed in a saved run of the spell checker
+static vector<string> readMisspelled(string path) {
+	std::ifstream file(path);
+	if (!file) {
+		throw FileError("Cannot open '" + path + "'");
+	}
+	vector<string> words;
+	string line;
+	bool listing = false;
+	while (std::getline(file, line)) {
+		if (line == "The following words are not in the dictionary:") {
+			listing = true;
+		}
+		else if (line.empty()) {
+			listing = false;
+		}
+		else if (listing && line.rfind("Did you mean", 0) != 0) {
+			words.push_back(line);
+		}
+	}
+	return words;
+}
+
+// Latency and reach of the suggestion strategies on misspelled words
+static void benchSuggest(int argc, char** argv) {
+	if (argc != 2) {
+		throw InvalidOption("Usage: ./benchmark suggest <dict-file> <run-output>");
+	}
+	auto dict = DictionaryBuilder(wyhash, 1).build(argv[0]);
+	vector<string> words = readMisspelled(argv[1]);
+	cout << words.size() << " misspelled words, " << dict->size() << " dictionary words" << endl;
+	cout << std::setw(16) << "engine" << std::setw(12) << "build ms" << std::setw(12) << "us/word"
+		<< std::setw(12) << "suggested" << std::setw(12) << "matches" << endl;
+	auto report = [&](string name, double build_ms, double ms, size_t suggested, size_t matches) {
+		cout << std::setw(16) << name << std::fixed << std::setprecision(1) << std::setw(12) << build_ms
+			<< std::setw(12) << 1000 * ms / words.size() << std::setw(12) << suggested << std::setw(12) << matches << endl;
+	};
+
+	Autocorrect autocorrect(*dict);
+	size_t suggested = 0;
+	double ms = timeMs([&]() {
+		for (const auto& word : words) {
+			suggested += autocorrect.attemptAutocorrect(word) != "";
+		}
+	});
+	report("strategies", 0, ms, suggested, suggested);
+
+	auto benchEngine = [&](string name, std::function<std::unique_ptr<Suggester>()> build) {
+		std::unique_ptr<Suggester> engine;
+		double build_ms = timeMs([&]() { engine = build(); });
+		for (size_t k = 1; k <= engine->maxDistance(); ++k) {
+			size_t num_suggested = 0, num_matches = 0;
+			double find_ms = timeMs([&]() {
+				for (const auto& word : words) {
+					size_t n = engine->find(word, k).size();
+					num_suggested += n > 0;
+					num_matches += n;
+				}
+			});
+			report(name + " k=" + std::to_string(k), build_ms, find_ms, num_suggested, num_matches);
+		}
+	};
+	benchEngine("symspell", [&]() { return std::make_unique<DeletionIndex>(*dict, wyhash, 2, size_t(1) << 30); });
+	benchEngine("trie", [&]() { return std::make_unique<Trie>(*dict, 3); });
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		cout << "Usage: ./benchmark <section> [args...]" << endl;
+		cout << "Sections:" << endl;
+		cout << "    hash <files...>         hash functions throughput and distribution" << endl;
+		cout << "    normalize <files...>    word normalization kernels throughput" << endl;
+		cout << "    rbtree <files...>       red-black tree insert, iterate and delete throughput" << endl;
+		cout << "    sort <files...>         multikey quicksort against std::sort" << endl;
+		cout << "    lookup <dict> <files...>  dictionary lookups one at a time and batched" << endl;
+		cout << "    suggest <dict> <run-output>  suggestion engines on the misspelled words of a run" << endl;
+		return 1;
+	}
+	try {
+		string section = argv[1];
+		if (section == "hash") {
+			benchHashers(argc - 2, argv + 2);
+		}
+		else if (section == "normalize") {
+			benchNormalizers(argc - 2, argv + 2);
+		}
+		else if (section == "rbtree") {
+			benchRBTree(argc - 2, argv + 2);
+		}
+		else if (section == "sort") {
+			benchSort(argc - 2, argv + 2);
+		}
+		else if (section == "lookup") {
+			benchLookup(argc - 2, argv + 2);
+		}
+		else if (section == "suggest") {
+			benchSuggest(argc - 2, argv + 2);
+		}
+		else {
+			throw InvalidOption("Unknown section '" + section + "'");
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
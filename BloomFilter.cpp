@@ -0,0 +1,116 @@
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "BloomFilter.h"
+
+using std::string_view;
+
+// Remixes a hash into bits independent of those picking the block
+static inline uint64_t remix(uint64_t hash) {
+	hash ^= hash >> 31;
+	hash *= 0x9E3779B97F4A7C15ull;
+	return hash ^ (hash >> 29);
+}
+
+BloomFilter::BloomFilter(string_hash_t hash_func, size_t expected_count, double false_positive_rate)
+	: m_hash_func(hash_func)
+	, m_count(0) {
+	// Optimal classic Bloom filter: m = -n ln(p) / ln(2)^2 bits, k = m/n ln(2)
+	double bits_per_key = -std::log(false_positive_rate) / (std::log(2) * std::log(2));
+	size_t num_bits = static_cast<size_t>(std::max<size_t>(expected_count, 1) * bits_per_key);
+	m_blocks.resize(std::max<size_t>((num_bits + BLOCK_BITS - 1) / BLOCK_BITS, 1), Block{});
+	m_num_hashes = std::clamp<size_t>(std::lround(bits_per_key * std::log(2)), 1, 16);
+}
+
+BloomFilter::~BloomFilter() {}
+
+// Bits of a key within its block are taken 9 at a time from a stream of
+// remixes of its hash
+constexpr size_t BIT_INDEX_BITS = 9;
+constexpr size_t BIT_INDEXES_PER_WORD = 64 / BIT_INDEX_BITS;
+
+size_t BloomFilter::blockIndexOf(uint64_t hash) const {
+	// The high half of the hash picks the block
+	return ((hash >> 32) * m_blocks.size()) >> 32;
+}
+
+const BloomFilter::Block& BloomFilter::blockOf(uint64_t hash) const {
+	return m_blocks[blockIndexOf(hash)];
+}
+
+BloomFilter::Block& BloomFilter::blockOf(uint64_t hash) {
+	return m_blocks[blockIndexOf(hash)];
+}
+
+void BloomFilter::insert(string_view key) {
+	uint64_t hash = m_hash_func(key);
+	Block& block = blockOf(hash);
+	uint64_t bits = hash;
+	for (size_t i = 0; i < m_num_hashes; ++i) {
+		if (i % BIT_INDEXES_PER_WORD == 0) {
+			bits = remix(bits + i);
+		}
+		size_t bit = bits & (BLOCK_BITS - 1);
+		bits >>= BIT_INDEX_BITS;
+		block.words[bit / 64] |= uint64_t(1) << (bit % 64);
+	}
+	++m_count;
+}
+
+bool BloomFilter::mayContain(string_view key) const {
+	return mayContain(m_hash_func(key));
+}
+
+uint64_t BloomFilter::mayContainMany(const string_view* keys, size_t count) const {
+	assert(count <= MAX_BATCH);
+	uint64_t hashes[MAX_BATCH];
+	for (size_t i = 0; i < count; ++i) {
+		hashes[i] = m_hash_func(keys[i]);
+		__builtin_prefetch(&blockOf(hashes[i]));
+	}
+	uint64_t res = 0;
+	for (size_t i = 0; i < count; ++i) {
+		res |= static_cast<uint64_t>(mayContain(hashes[i])) << i;
+	}
+	return res;
+}
+
+bool BloomFilter::mayContain(uint64_t hash) const {
+	const Block& block = blockOf(hash);
+	uint64_t bits = hash;
+	for (size_t i = 0; i < m_num_hashes; ++i) {
+		if (i % BIT_INDEXES_PER_WORD == 0) {
+			bits = remix(bits + i);
+		}
+		size_t bit = bits & (BLOCK_BITS - 1);
+		bits >>= BIT_INDEX_BITS;
+		if (!(block.words[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+double BloomFilter::estimatedFalsePositiveRate() const {
+	// The number of keys in a block is Poisson distributed. Sum the false
+	// positive rate of a block holding j keys, weighted by its probability
+	double mean = static_cast<double>(m_count) / m_blocks.size();
+	double res = 0;
+	double prob = std::exp(-mean); // P(j = 0)
+	for (size_t j = 0; j < mean + 10*std::sqrt(mean) + 10; ++j) {
+		double bit_set = 1 - std::pow(1 - 1.0 / BLOCK_BITS, static_cast<double>(m_num_hashes * j));
+		res += prob * std::pow(bit_set, static_cast<double>(m_num_hashes));
+		prob *= mean / (j + 1);
+	}
+	return res;
+}
+
+size_t BloomFilter::sizeBytes() const {
+	return m_blocks.size() * sizeof(Block);
+}
+
+size_t BloomFilter::numHashes() const {
+	return m_num_hashes;
+}
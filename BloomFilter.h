@@ -0,0 +1,75 @@
+
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "hash.h"
+
+/**
+ * A blocked Bloom filter of strings: a set which may return false positives,
+ * but never false negatives.
+ * The bits are split into cache line sized blocks. All the bits of a key are
+ * set in one block picked by its hash, so testing a key touches a single
+ * cache line, at the cost of a slightly higher false positive rate than a
+ * classic Bloom filter of the same size.
+ */
+class BloomFilter final {
+public:
+	// Most keys of a mayContainMany call, one per bit of its result
+	static constexpr size_t MAX_BATCH = 64;
+
+	// Construct an empty filter sized for expected_count keys at the given
+	// false positive rate, hashing keys with hash_func
+	BloomFilter(string_hash_t hash_func, size_t expected_count, double false_positive_rate);
+	~BloomFilter();
+
+	// Adds a key to the filter
+	void insert(std::string_view key);
+
+	// False iff the key was surely not inserted
+	bool mayContain(std::string_view key) const;
+
+	// mayContain of each of count (at most MAX_BATCH) keys: bit i of the result is
+	// set iff keys[i] may have been inserted. Prefetches the blocks of all
+	// keys before testing any
+	uint64_t mayContainMany(const std::string_view* keys, size_t count) const;
+
+	// Expected false positive rate, given the number of keys inserted
+	double estimatedFalsePositiveRate() const;
+
+	// Size of the filter in bytes
+	size_t sizeBytes() const;
+
+	// Number of bits set per key
+	size_t numHashes() const;
+
+private:
+	// Bits per block, a cache line
+	static constexpr size_t BLOCK_BITS = 512;
+	static constexpr size_t WORDS_PER_BLOCK = BLOCK_BITS / 64;
+
+	// A cache line of bits
+	struct alignas(64) Block {
+		uint64_t words[WORDS_PER_BLOCK];
+	};
+
+	// Block holding the bits of a key, by its hash
+	const Block& blockOf(uint64_t hash) const;
+	Block& blockOf(uint64_t hash);
+
+	// Index in m_blocks of blockOf(hash)
+	size_t blockIndexOf(uint64_t hash) const;
+
+	// mayContain of a key whose hash was already computed
+	bool mayContain(uint64_t hash) const;
+
+	string_hash_t m_hash_func;
+	std::vector<Block> m_blocks;
+	size_t m_num_hashes;
+	size_t m_count;
+};
+
+#endif
@@ -0,0 +1,48 @@
+
+#include <chrono>
+#include <iostream>
+
+#include "Client.h"
+#include "Exceptions.h"
+#include "Socket.h"
+
+using std::cout, std::cerr, std::endl, std::string;
+
+// Sends a request and writes the response, with the round trip and server
+// time in microseconds
+static void request(const Socket& server, const string& message) {
+	auto start = std::chrono::steady_clock::now();
+	server.send(message);
+	string response;
+	if (!server.receive(response)) {
+		throw SocketError("Server closed the connection");
+	}
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	size_t newline = std::min(response.find('\n'), response.length());
+	string status = response.substr(0, newline);
+	string body = response.substr(std::min(newline + 1, response.length()));
+	size_t space = std::min(status.find(' '), status.length());
+	if (status.substr(0, space) != "ok") {
+		throw InvalidOption("Server: " + body.substr(0, body.find('\n')));
+	}
+	cout << body << std::flush;
+	cerr << "Latency: " << us << " us (" << status.substr(std::min(space + 1, status.length()))
+		<< " us in server)" << endl;
+}
+
+void runClient(const string& socket_path, const string& command, const std::vector<string>& texts) {
+	Socket server = Socket::connect(socket_path);
+	if (!texts.empty()) {
+		string message = command;
+		for (const auto& text : texts) {
+			message += " " + text;
+		}
+		request(server, message);
+		return;
+	}
+	string line;
+	while (std::getline(std::cin, line)) {
+		request(server, command + " " + line);
+	}
+}
@@ -0,0 +1,15 @@
+
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <string>
+#include <vector>
+
+// Sends requests to a server started by App::serve at socket_path, writing
+// the body of each response to stdout and its latency to stderr. Sends a
+// single request of the command and texts joined by spaces, or if there are
+// no texts, a request per line of standard input. Throws SocketError if the
+// server cannot be reached, and InvalidOption if it reports an error
+void runClient(const std::string& socket_path, const std::string& command, const std::vector<std::string>& texts);
+
+#endif
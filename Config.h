@@ -0,0 +1,89 @@
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <string>
+#include <thread>
+
+#include "hash.h"
+
+/**
+ * Options of the spell checker, set from the command line.
+ */
+struct Config final {
+	// Name of the string hash function used by the hash tables
+	std::string hash_name = DEFAULT_HASHER;
+
+	// Keep the dictionary in a minimal word graph (DAWG) instead of a hash
+	// table, and write a word graph rather than an index with --build-index
+	bool use_word_graph = false;
+
+	// Keep the dictionary partitioned by word length, each length in its
+	// own compact table
+	bool partition_by_length = false;
+
+	// False positive rate of the Bloom filter in front of the dictionary.
+	// 0 for no filter
+	double bloom_false_positive_rate = 0;
+
+	// Suggestion engine searched when the edit strategies find none:
+	// "symspell" (a deletion index), "trie", or empty for none
+	std::string fallback_engine;
+
+	// Largest distance of suggestions searched by the fallback engine
+	size_t fallback_distance = 0;
+
+	// Memory cap of the deletion index, in MB
+	size_t deletion_memory_mb = 256;
+
+	// Number of suggestions (and of words without one) cached across
+	// checked files. 0 for no cache, unless a cache file is given
+	size_t cache_size = 0;
+
+	// File the suggestion cache is loaded from and saved to. Empty for none
+	std::string cache_path;
+
+	// Number of ranked suggestions shown per misspelled word. 0 for only
+	// the first word found by the edit strategies, unless ranking is
+	// otherwise configured
+	size_t top_suggestions = 0;
+
+	// File of word frequencies ranking suggestions. Empty for none
+	std::string frequency_path;
+
+	// Budget of ranking the suggestions of a word: number of dictionary
+	// lookups, and time in microseconds. 0 for unbounded
+	size_t max_probes = 0;
+	size_t max_suggest_us = 0;
+
+	// Number of threads to use
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// Number of checked files checked at a time
+	size_t jobs = 1;
+
+	// Check standard input (or the given files) as it is read, reporting
+	// each misspelled word when first seen
+	bool stream = false;
+
+	// Number of words remembered as seen while streaming
+	size_t stream_seen_cap = 1 << 20;
+
+	// Unix domain socket to serve check and suggest requests on, instead of
+	// checking files. Empty for none
+	std::string serve_path;
+
+	// Number of requests answered at a time, each on a thread of its own.
+	// Idle clients are not counted
+	size_t max_clients = 64;
+
+	// Format of the reports of checked files: "text", or "jsonl" for a JSON
+	// object per misspelled word
+	std::string report_format = "text";
+
+	// Collect the words of checked files in a red-black tree and filter it,
+	// instead of checking each unique word once and sorting the misspelled
+	bool use_tree = false;
+};
+
+#endif
@@ -0,0 +1,186 @@
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "DeletionIndex.h"
+#include "Exceptions.h"
+
+using std::string, std::string_view, std::vector;
+
+// Number of ways to choose k of n
+static size_t choose(size_t n, size_t k) {
+	if (k > n) {
+		return 0;
+	}
+	size_t res = 1;
+	for (size_t i = 1; i <= k; ++i) {
+		res = res * (n - k + i) / i;
+	}
+	return res;
+}
+
+// Optimal string alignment distance between a and b, or max+1 if it is more
+// than max. rows is scratch space
+static size_t osaDistance(string_view a, string_view b, size_t max, vector<size_t>& rows) {
+	size_t width = b.length() + 1;
+	rows.resize(3 * width);
+	size_t* prev2 = rows.data();
+	size_t* prev = prev2 + width;
+	size_t* cur = prev + width;
+	for (size_t j = 0; j < width; ++j) {
+		prev[j] = j;
+	}
+	for (size_t i = 1; i <= a.length(); ++i) {
+		cur[0] = i;
+		size_t row_min = i;
+		for (size_t j = 1; j < width; ++j) {
+			size_t cost = a[i-1] == b[j-1] ? 0 : 1;
+			cur[j] = std::min({prev[j] + 1, cur[j-1] + 1, prev[j-1] + cost});
+			if (i > 1 && j > 1 && a[i-1] == b[j-2] && a[i-2] == b[j-1]) {
+				cur[j] = std::min(cur[j], prev2[j-2] + 1);
+			}
+			row_min = std::min(row_min, cur[j]);
+		}
+		if (row_min > max) {
+			return max + 1;
+		}
+		std::swap(prev2, prev);
+		std::swap(prev, cur);
+	}
+	return std::min(prev[width-1], max + 1);
+}
+
+DeletionIndex::DeletionIndex(const Dictionary& dict, string_hash_t hash_func, size_t max_distance, size_t memory_cap)
+	: m_hash_func(hash_func)
+	, m_max_distance(max_distance)
+	, m_prefix_length(0) {
+	if (max_distance < 1 || max_distance > MAX_DISTANCE) {
+		throw InvalidOption("Deletion index distance must be between 1 and " + std::to_string(MAX_DISTANCE));
+	}
+	// Number of words by the length of their prefix
+	std::array<size_t, MAX_PREFIX_LENGTH+1> prefix_lengths{};
+	m_offsets.reserve(dict.size() + 1);
+	dict.forEachWord([&](const string& word) {
+		m_offsets.push_back(m_chars.size());
+		m_chars += word;
+		++prefix_lengths[std::min(word.length(), MAX_PREFIX_LENGTH)];
+	});
+	m_offsets.push_back(m_chars.size());
+	if (m_chars.size() > std::numeric_limits<uint32_t>::max()) {
+		throw InvalidOption("Dictionary is too large for a deletion index");
+	}
+
+	// Longest prefix whose (upper bound of) entries fit in the cap. A prefix
+	// must be longer than the distance, or whole words would be deleted
+	size_t words_bytes = m_chars.capacity() + m_offsets.capacity() * sizeof(uint32_t);
+	size_t num_entries = 0;
+	for (size_t prefix_length = MAX_PREFIX_LENGTH; prefix_length > max_distance; --prefix_length) {
+		num_entries = 0;
+		for (size_t len = 0; len <= MAX_PREFIX_LENGTH; ++len) {
+			for (size_t d = 0; d <= max_distance; ++d) {
+				num_entries += prefix_lengths[len] * choose(std::min(len, prefix_length), d);
+			}
+		}
+		if (words_bytes + num_entries * sizeof(uint64_t) <= memory_cap) {
+			m_prefix_length = prefix_length;
+			break;
+		}
+	}
+	if (m_prefix_length == 0) {
+		throw InvalidOption("Deletion index of distance " + std::to_string(max_distance)
+			+ " does not fit in " + std::to_string(memory_cap >> 20) + " MB");
+	}
+
+	m_entries.reserve(num_entries);
+	for (uint32_t idx = 0; idx + 1 < m_offsets.size(); ++idx) {
+		forEachDeletion(wordAt(idx), max_distance, [&](uint32_t hash) {
+			m_entries.push_back(static_cast<uint64_t>(hash) << 32 | idx);
+		});
+	}
+	std::sort(m_entries.begin(), m_entries.end());
+}
+
+DeletionIndex::~DeletionIndex() {}
+
+template <class F>
+void DeletionIndex::forEachDeletion(string_view word, size_t max_distance, F func) const {
+	string_view prefix = word.substr(0, m_prefix_length);
+	size_t len = prefix.length();
+	std::array<uint32_t, 1 << MAX_PREFIX_LENGTH> hashes;
+	size_t num_hashes = 0;
+	char buf[MAX_PREFIX_LENGTH];
+	// Each deletion by the bit mask of the deleted letters
+	for (uint32_t deleted = 0; deleted < (1u << len); ++deleted) {
+		if (static_cast<size_t>(__builtin_popcount(deleted)) > max_distance) {
+			continue;
+		}
+		size_t buf_len = 0;
+		for (size_t i = 0; i < len; ++i) {
+			if (!(deleted & (1u << i))) {
+				buf[buf_len++] = prefix[i];
+			}
+		}
+		size_t hash = m_hash_func(string_view(buf, buf_len));
+		hashes[num_hashes++] = static_cast<uint32_t>(hash ^ (hash >> 32));
+	}
+	// Deleting either of two equal letters gives the same string
+	std::sort(hashes.begin(), hashes.begin() + num_hashes);
+	auto end = std::unique(hashes.begin(), hashes.begin() + num_hashes);
+	for (auto it = hashes.begin(); it != end; ++it) {
+		func(*it);
+	}
+}
+
+vector<DeletionIndex::Match> DeletionIndex::find(string_view word, size_t max_distance) const {
+	max_distance = std::min(max_distance, m_max_distance);
+	vector<uint32_t> candidates;
+	forEachDeletion(word, max_distance, [&](uint32_t hash) {
+		uint64_t key = static_cast<uint64_t>(hash) << 32;
+		auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key);
+		for (; it != m_entries.end() && (*it >> 32) == hash; ++it) {
+			candidates.push_back(static_cast<uint32_t>(*it));
+		}
+	});
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	// Sort the candidates before building matches, so only the matches
+	// that are returned are copied
+	vector<std::pair<size_t, string_view>> found;
+	vector<size_t> rows;
+	for (uint32_t idx : candidates) {
+		string_view candidate = wordAt(idx);
+		size_t len_diff = std::max(word.length(), candidate.length()) - std::min(word.length(), candidate.length());
+		if (len_diff > max_distance) {
+			continue;
+		}
+		size_t distance = osaDistance(word, candidate, max_distance, rows);
+		if (distance <= max_distance) {
+			found.emplace_back(distance, candidate);
+		}
+	}
+	std::sort(found.begin(), found.end());
+	vector<Match> matches;
+	matches.reserve(found.size());
+	for (const auto& [distance, candidate] : found) {
+		matches.push_back(Match{string(candidate), distance});
+	}
+	return matches;
+}
+
+string_view DeletionIndex::wordAt(uint32_t idx) const {
+	return string_view(m_chars.data() + m_offsets[idx], m_offsets[idx+1] - m_offsets[idx]);
+}
+
+size_t DeletionIndex::maxDistance() const {
+	return m_max_distance;
+}
+
+size_t DeletionIndex::prefixLength() const {
+	return m_prefix_length;
+}
+
+size_t DeletionIndex::sizeBytes() const {
+	return m_chars.capacity() + m_offsets.capacity() * sizeof(uint32_t) + m_entries.capacity() * sizeof(uint64_t);
+}
@@ -0,0 +1,75 @@
+
+#ifndef DELETIONINDEX_H
+#define DELETIONINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Dictionary.h"
+#include "Suggester.h"
+#include "hash.h"
+
+/**
+ * Index of the words of a dictionary by their deletions (SymSpell), finding
+ * all words within a Damerau-Levenshtein (optimal string alignment) distance
+ * of k from a word with a bounded number of lookups.
+ * Two words within distance k share a string reachable from each by deleting
+ * at most k letters. So every string obtained by deleting up to k letters
+ * from a dictionary word is indexed, and a query looks up each string
+ * obtained by deleting up to k letters from the queried word. Candidates are
+ * then verified by computing their distance.
+ * Only deletions of the first 'prefix length' letters are indexed - the
+ * prefix length is the largest one whose index fits in the memory cap. A
+ * shorter prefix means fewer entries, but more candidates to verify.
+ * Deletions are indexed by a 32 bits hash rather than by value: collisions
+ * only add candidates, which are verified anyway.
+ */
+class DeletionIndex final : public Suggester {
+public:
+	// Largest supported distance
+	static constexpr size_t MAX_DISTANCE = 4;
+
+	// Indexes the words of dict for queries of distance up to max_distance,
+	// in at most memory_cap bytes. Throws InvalidOption if max_distance is
+	// not supported, or the index cannot fit in the cap
+	DeletionIndex(const Dictionary& dict, string_hash_t hash_func, size_t max_distance, size_t memory_cap);
+	~DeletionIndex();
+
+	std::vector<Match> find(std::string_view word, size_t max_distance) const override;
+
+	// Distance the index was built for
+	size_t maxDistance() const override;
+
+	// Number of first letters of words whose deletions are indexed
+	size_t prefixLength() const;
+
+	// Memory used by the index in bytes
+	size_t sizeBytes() const;
+
+private:
+	// Longest prefix length considered (the SymSpell default)
+	static constexpr size_t MAX_PREFIX_LENGTH = 7;
+
+	// Calls func with the 32 bits hash of every distinct string obtained by
+	// deleting up to max_distance letters from the prefix of word
+	template <class F>
+	void forEachDeletion(std::string_view word, size_t max_distance, F func) const;
+
+	// Word number idx
+	std::string_view wordAt(uint32_t idx) const;
+
+	string_hash_t m_hash_func;
+	size_t m_max_distance;
+	size_t m_prefix_length;
+
+	// All words, back to back, and the offset of each (plus the end)
+	std::string m_chars;
+	std::vector<uint32_t> m_offsets;
+
+	// Entries of (deletion hash << 32 | word number), sorted
+	std::vector<uint64_t> m_entries;
+};
+
+#endif
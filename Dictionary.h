@@ -0,0 +1,45 @@
+
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/**
+ * Interface of a read-only set of words. This is all Autocorrect and App need
+ * from a dictionary, allowing the words to be kept in different backends.
+ */
+class Dictionary {
+public:
+	// Callback receiving dictionary words
+	using word_func_t = std::function<void(const std::string&)>;
+
+	virtual ~Dictionary() {}
+
+	// Largest number of words checked by one lookupMany call
+	static constexpr size_t MAX_BATCH = 64;
+
+	// Check whether a word is in the dictionary
+	virtual bool lookup(std::string_view word) const = 0;
+
+	// Check whether each of count (at most MAX_BATCH) words is in the
+	// dictionary: bit i of the result is set iff words[i] is. Backends
+	// override this to overlap the memory accesses of the lookups
+	virtual uint64_t lookupMany(const std::string_view* words, size_t count) const {
+		uint64_t res = 0;
+		for (size_t i = 0; i < count; ++i) {
+			res |= static_cast<uint64_t>(lookup(words[i])) << i;
+		}
+		return res;
+	}
+
+	// Number of unique words in the dictionary
+	virtual size_t size() const = 0;
+
+	// Call func with every word in the dictionary, in no particular order
+	virtual void forEachWord(word_func_t func) const = 0;
+};
+
+#endif
@@ -0,0 +1,89 @@
+
+#include <filesystem>
+
+#include "DictionaryBuilder.h"
+#include "Exceptions.h"
+#include "MappedFile.h"
+#include "ShardedReader.h"
+#include "ThreadPool.h"
+
+using std::string, std::vector;
+
+// Dictionary files have a word per line, of around 10 bytes on average.
+// Underestimating the number of words just costs some (incremental) rehashing
+constexpr size_t DICT_BYTES_PER_WORD = 10;
+
+DictionaryBuilder::DictionaryBuilder(string_hash_t hash_func, size_t num_threads)
+	: m_hash_func(hash_func)
+	, m_num_threads(std::max<size_t>(num_threads, 1))
+	, m_num_words_in_file(0) {}
+
+DictionaryBuilder::~DictionaryBuilder() {}
+
+size_t DictionaryBuilder::readChunk(FileReader& fr, partitions_t& partitions, const HashDictionary& dict) const {
+	size_t num_words = 0;
+	std::string_view word = fr.getWordView();
+	while (!word.empty()) {
+		++num_words;
+		size_t hash = m_hash_func(word);
+		partitions[dict.shardOf(hash)].emplace_back(word, hash);
+		word = fr.getWordView();
+	}
+	return num_words;
+}
+
+std::unique_ptr<HashDictionary> DictionaryBuilder::build(string path) {
+	std::unique_ptr<MappedFile> file;
+	try {
+		file = std::make_unique<MappedFile>(path);
+	}
+	catch (const FileError& e) {
+		// Not a regular file, will be read on a single thread
+	}
+	size_t num_threads = file ? m_num_threads : 1;
+	size_t num_shards = ShardedReader::numShards(num_threads);
+	std::error_code err;
+	size_t file_size = std::filesystem::file_size(path, err);
+	auto dict = std::make_unique<HashDictionary>(m_hash_func,
+		err ? 0 : file_size / DICT_BYTES_PER_WORD, num_shards);
+
+	// Words of each chunk, by shard
+	vector<partitions_t> chunks(num_threads, partitions_t(num_shards));
+	vector<size_t> num_words(num_threads, 0);
+	auto merge = [&](size_t shard) {
+		for (auto& chunk : chunks) {
+			for (auto& [word, hash] : chunk[shard]) {
+				try {
+					dict->insert(std::move(word), hash);
+				}
+				// Some words are double in lower/upper case,
+				// or they are the same as another word with non-alphanumeric characters in it.
+				catch (const KeyAlreadyExists& e) {}
+			}
+			// Release memory as we go
+			vector<std::pair<string, size_t>>().swap(chunk[shard]);
+		}
+	};
+	if (!file) {
+		FileReader fr(path);
+		num_words[0] = readChunk(fr, chunks[0], *dict);
+		merge(0);
+	}
+	else {
+		ThreadPool pool(num_threads);
+		ShardedReader reader(pool, *file, num_threads);
+		reader.read([&](size_t chunk, FileReader& fr) {
+			num_words[chunk] = readChunk(fr, chunks[chunk], *dict);
+		}, merge);
+	}
+
+	m_num_words_in_file = 0;
+	for (size_t n : num_words) {
+		m_num_words_in_file += n;
+	}
+	return dict;
+}
+
+size_t DictionaryBuilder::numWordsInFile() const {
+	return m_num_words_in_file;
+}
@@ -0,0 +1,45 @@
+
+#ifndef DICTIONARYBUILDER_H
+#define DICTIONARYBUILDER_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FileReader.h"
+#include "HashDictionary.h"
+#include "hash.h"
+
+/**
+ * Builds a HashDictionary from a dictionary file on several threads, by a
+ * ShardedReader with a chunk per thread. Each thread tokenizes and hashes
+ * its chunk, partitioning the words by the shard of the dictionary they
+ * belong to. Then each shard is filled from the matching partitions of all
+ * chunks, in file order - so the same duplicates are found as when reading
+ * the file on a single thread.
+ */
+class DictionaryBuilder final {
+public:
+	DictionaryBuilder(string_hash_t hash_func, size_t num_threads);
+	~DictionaryBuilder();
+
+	// Builds a dictionary of the words in the file at path
+	std::unique_ptr<HashDictionary> build(std::string path);
+
+	// Number of words (with repetitions) in the last file built
+	size_t numWordsInFile() const;
+
+private:
+	// Words of a chunk (and their hashes), partitioned by shard
+	using partitions_t = std::vector<std::vector<std::pair<std::string, size_t>>>;
+
+	// Tokenizes a chunk into partitions. Returns number of words in it
+	size_t readChunk(FileReader& fr, partitions_t& partitions, const HashDictionary& dict) const;
+
+	string_hash_t m_hash_func;
+	size_t m_num_threads;
+	size_t m_num_words_in_file;
+};
+
+#endif
@@ -0,0 +1,205 @@
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "DictionaryIndex.h"
+#include "Exceptions.h"
+
+using std::string, std::string_view, std::vector;
+
+constexpr char INDEX_MAGIC[8] = {'S', 'P', 'L', 'C', 'H', 'I', 'D', 'X'};
+
+// Bump whenever the layout of the index changes
+constexpr uint32_t INDEX_VERSION = 3;
+
+struct DictionaryIndex::Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t hash_id; // of the hash function used to place words in the table
+	uint64_t num_words_in_file;
+	uint64_t num_words;
+	uint64_t num_slots; // power of 2
+	uint64_t num_chars; // size of the characters blob, padded to 8 bytes
+	uint64_t checksum; // of the fields above and everything following the header
+};
+
+struct DictionaryIndex::Slot {
+	uint32_t offset; // of the word in the characters blob
+	uint16_t length; // of the word. 0 iff the slot is empty
+	uint16_t tag; // high bits of the hash of the word
+};
+
+static uint16_t tagOf(size_t hash) {
+	return static_cast<uint16_t>(hash >> (sizeof(size_t)*8 - 16));
+}
+
+uint64_t DictionaryIndex::checksumOf(const Header& header, const char* body, size_t body_size) {
+	static_assert(offsetof(Header, checksum) % 8 == 0, "fileChecksum consumes 8 bytes at a time");
+	uint64_t header_checksum = fileChecksum(reinterpret_cast<const char*>(&header), offsetof(Header, checksum));
+	return fileChecksum(body, body_size, header_checksum);
+}
+
+DictionaryIndex::DictionaryIndex(string path)
+	: m_file(path) {
+	if (m_file.size() < sizeof(Header)) {
+		throw InvalidIndex("'" + path + "' is too short to be an index");
+	}
+	m_header = reinterpret_cast<const Header*>(m_file.data());
+	if (memcmp(m_header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+		throw InvalidIndex("'" + path + "' is not an index");
+	}
+	if (m_header->version != INDEX_VERSION) {
+		throw InvalidIndex("'" + path + "' was built by an incompatible version, rebuild it");
+	}
+	const Hasher* hasher = findHasher(m_header->hash_id);
+	if (!hasher) {
+		throw InvalidIndex("'" + path + "' uses a hash function unavailable on this machine, rebuild it");
+	}
+	m_hash_func = hasher->func;
+	// Sizes are checked against the file before multiplying, so a corrupted
+	// header cannot overflow them
+	size_t num_slots = m_header->num_slots;
+	size_t body_size = m_file.size() - sizeof(Header);
+	if (num_slots > body_size / sizeof(Slot) || m_header->num_chars != body_size - num_slots * sizeof(Slot)) {
+		throw InvalidIndex("'" + path + "' is truncated");
+	}
+	const char* body = m_file.data() + sizeof(Header);
+	if (checksumOf(*m_header, body, body_size) != m_header->checksum) {
+		throw InvalidIndex("'" + path + "' is corrupted (checksum mismatch)");
+	}
+	// A checksum only catches accidents, so the table is also checked to be
+	// addressable: a power of 2 of slots, with an empty one ending every
+	// probe, and words within the characters blob
+	if (num_slots == 0 || (num_slots & (num_slots - 1)) != 0 || m_header->num_words >= num_slots) {
+		throw InvalidIndex("'" + path + "' is corrupted (bad table size)");
+	}
+	m_slots = reinterpret_cast<const Slot*>(body);
+	m_chars = body + num_slots * sizeof(Slot);
+	m_mask = num_slots - 1;
+	size_t num_words = 0;
+	for (size_t i = 0; i < num_slots; ++i) {
+		if (m_slots[i].length != 0) {
+			++num_words;
+			if (m_slots[i].offset > m_header->num_chars
+				|| m_slots[i].length > m_header->num_chars - m_slots[i].offset) {
+				throw InvalidIndex("'" + path + "' is corrupted (word out of bounds)");
+			}
+		}
+	}
+	if (num_words != m_header->num_words) {
+		throw InvalidIndex("'" + path + "' is corrupted (bad word count)");
+	}
+}
+
+DictionaryIndex::~DictionaryIndex() {}
+
+void DictionaryIndex::write(const Dictionary& dict, size_t num_words_in_file,
+	const Hasher& hasher, string path) {
+	// Keep load factor at most 1/2, misses are the common case for Autocorrect
+	size_t num_slots = 8;
+	while (num_slots < 2*dict.size()) {
+		num_slots <<= 1;
+	}
+	vector<Slot> slots(num_slots, Slot{0, 0, 0});
+	string chars;
+	dict.forEachWord([&](const string& word) {
+		if (word.length() > UINT16_MAX || chars.length() + word.length() > UINT32_MAX) {
+			throw InvalidIndex("Dictionary is too large to be indexed");
+		}
+		size_t word_hash = hasher.func(word);
+		size_t idx = word_hash & (num_slots - 1);
+		while (slots[idx].length != 0) {
+			idx = (idx + 1) & (num_slots - 1);
+		}
+		slots[idx] = Slot{static_cast<uint32_t>(chars.length()),
+			static_cast<uint16_t>(word.length()), tagOf(word_hash)};
+		chars += word;
+	});
+	chars.resize((chars.length() + 7) & ~size_t(7), '\0');
+
+	string body(reinterpret_cast<const char*>(slots.data()), num_slots * sizeof(Slot));
+	body += chars;
+
+	Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	header.version = INDEX_VERSION;
+	header.hash_id = hasher.id;
+	header.num_words_in_file = num_words_in_file;
+	header.num_words = dict.size();
+	header.num_slots = num_slots;
+	header.num_chars = chars.length();
+	header.checksum = checksumOf(header, body.data(), body.length());
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(body.data(), body.length());
+	if (!out) {
+		throw FileError("Cannot write index to '" + path + "'");
+	}
+}
+
+bool DictionaryIndex::isIndex(string path) {
+	// Indexes are mapped, so must be regular files. Reading the start of
+	// anything else (e.g. a pipe) would consume it
+	std::error_code err;
+	if (!std::filesystem::is_regular_file(path, err)) {
+		return false;
+	}
+	std::ifstream in(path, std::ios::binary);
+	char magic[sizeof(INDEX_MAGIC)];
+	if (!in.read(magic, sizeof(magic))) {
+		return false;
+	}
+	return memcmp(magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0;
+}
+
+size_t DictionaryIndex::numWordsInFile() const {
+	return m_header->num_words_in_file;
+}
+
+bool DictionaryIndex::lookup(string_view word) const {
+	return lookup(word, m_hash_func(word));
+}
+
+uint64_t DictionaryIndex::lookupMany(const string_view* words, size_t count) const {
+	size_t hashes[MAX_BATCH];
+	for (size_t i = 0; i < count; ++i) {
+		hashes[i] = m_hash_func(words[i]);
+		__builtin_prefetch(&m_slots[hashes[i] & m_mask]);
+	}
+	uint64_t res = 0;
+	for (size_t i = 0; i < count; ++i) {
+		res |= static_cast<uint64_t>(lookup(words[i], hashes[i])) << i;
+	}
+	return res;
+}
+
+bool DictionaryIndex::lookup(string_view word, size_t word_hash) const {
+	uint16_t tag = tagOf(word_hash);
+	size_t idx = word_hash & m_mask;
+	while (m_slots[idx].length != 0) {
+		const Slot& slot = m_slots[idx];
+		if (slot.tag == tag && slot.length == word.length()
+			&& memcmp(m_chars + slot.offset, word.data(), slot.length) == 0) {
+			return true;
+		}
+		idx = (idx + 1) & m_mask;
+	}
+	return false;
+}
+
+size_t DictionaryIndex::size() const {
+	return m_header->num_words;
+}
+
+void DictionaryIndex::forEachWord(word_func_t func) const {
+	for (size_t i = 0; i <= m_mask; ++i) {
+		if (m_slots[i].length != 0) {
+			func(string(m_chars + m_slots[i].offset, m_slots[i].length));
+		}
+	}
+}
@@ -0,0 +1,71 @@
+
+#ifndef DICTIONARYINDEX_H
+#define DICTIONARYINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Dictionary.h"
+#include "MappedFile.h"
+#include "hash.h"
+
+/**
+ * A precompiled dictionary snapshot, queried in place via mmap.
+ * The index file is a header followed by an open-addressing table of fixed
+ * size slots and a blob of the words' characters. Slots refer to words by
+ * offset into the blob, so the file is position independent and is used as
+ * is, without parsing or per-word allocation.
+ * The header holds a format version, the id of the hash function used to
+ * build the table and a checksum of the rest of the header and the file.
+ * The table's size and the words' bounds are also validated on loading, so
+ * a corrupted index cannot make lookups read outside the mapping. An index not
+ * matching the running program on any of these is rejected as stale.
+ */
+class DictionaryIndex final : public Dictionary {
+public:
+	// Maps the index file at path. Throws InvalidIndex if it is stale or
+	// corrupted
+	DictionaryIndex(std::string path);
+	~DictionaryIndex();
+
+	// Writes a snapshot of dict into path, laid out by hasher.
+	// num_words_in_file is the number of words (with repetitions) the
+	// dictionary was built from, kept for reporting
+	static void write(const Dictionary& dict, size_t num_words_in_file,
+		const Hasher& hasher, std::string path);
+
+	// Check whether the file at path is a regular file starting like an index
+	// file
+	static bool isIndex(std::string path);
+
+	// Number of words (with repetitions) the index was built from
+	size_t numWordsInFile() const;
+
+	bool lookup(std::string_view word) const override;
+	uint64_t lookupMany(const std::string_view* words, size_t count) const override;
+	size_t size() const override;
+	void forEachWord(word_func_t func) const override;
+
+private:
+	// Layout of the file header
+	struct Header;
+
+	// Layout of a slot in the table
+	struct Slot;
+
+	// Checksum of the header fields before the checksum, and of the body
+	static uint64_t checksumOf(const Header& header, const char* body, size_t body_size);
+
+	// Check whether a word whose hash was already computed is in the index
+	bool lookup(std::string_view word, size_t word_hash) const;
+
+	MappedFile m_file;
+	const Header* m_header;
+	const Slot* m_slots;
+	const char* m_chars;
+	string_hash_t m_hash_func;
+	size_t m_mask;
+};
+
+#endif
@@ -2,7 +2,8 @@
 #ifndef EXCEPTIONS_H
 #define EXCEPTIONS_H
 
-#include <exception>
+#include <stdexcept>
+#include <string>
 
 #define DEF_EXCEPTION(superclass, exception) \
     class exception : public superclass { \
@@ -12,5 +13,9 @@
 
 DEF_EXCEPTION(std::runtime_error, KeyAlreadyExists);
 DEF_EXCEPTION(std::runtime_error, KeyNotFound);
+DEF_EXCEPTION(std::runtime_error, FileError);
+DEF_EXCEPTION(std::runtime_error, InvalidIndex);
+DEF_EXCEPTION(std::runtime_error, SocketError);
+DEF_EXCEPTION(std::invalid_argument, InvalidOption);
 
 #endif
@@ -1,38 +1,147 @@
 
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
 
+#include "Exceptions.h"
 #include "FileReader.h"
+#include "normalize.h"
 
-using std::string;
+using std::string, std::string_view;
+
+// Same as isspace in the "C" locale, without the function call and locale
+// lookup
+static inline bool isSpace(char c) {
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Bytes read at a time from a file which is not mapped, at most
+constexpr size_t READ_BLOCK_BYTES = 64 << 10;
+
+// Picked once, by the features of the running CPU
+static const normalize_func_t normalize = bestNormalizer();
 
 FileReader::FileReader(std::string path)
-	: m_file(path) {}
+	: m_mapped(false)
+	, m_fd(-1)
+	, m_pos(nullptr)
+	, m_end(nullptr)
+	, m_readable_end(nullptr) {
+	try {
+		m_mapping = std::make_unique<MappedFile>(path);
+		m_mapping->adviseSequential();
+		m_pos = m_mapping->data();
+		m_end = m_pos + m_mapping->size();
+		m_readable_end = m_end;
+		m_mapped = true;
+	}
+	catch (const FileError& e) {
+		// Not a regular file, or no such file (which reads as an empty file)
+		m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	}
+}
 
-FileReader::~FileReader() {}
+size_t FileReader::nextBoundary(const MappedFile& file, size_t pos) {
+	if (pos == 0) {
+		return 0;
+	}
+	while (pos < file.size() && !isSpace(file.data()[pos - 1])) {
+		++pos;
+	}
+	return std::min(pos, file.size());
+}
+
+FileReader::FileReader(const MappedFile& file, size_t begin, size_t end)
+	: m_mapped(true)
+	, m_fd(-1)
+	, m_pos(file.data() + begin)
+	, m_end(file.data() + end)
+	, m_readable_end(file.data() + file.size()) {}
+
+FileReader::FileReader(string_view text)
+	: m_mapped(true)
+	, m_fd(-1)
+	, m_pos(text.data())
+	, m_end(text.data() + text.length())
+	, m_readable_end(m_end) {}
+
+FileReader::~FileReader() {
+	if (m_fd >= 0) {
+		close(m_fd);
+	}
+}
 
 std::string FileReader::getWord() {
+	return string(getWordView());
+}
+
+bool FileReader::nextBlock(size_t keep) {
+	if (m_mapped || m_fd < 0) {
+		return false;
+	}
+	if (m_block.empty()) {
+		// Padded, so the kernels never need to copy tokens
+		m_block.resize(READ_BLOCK_BYTES + NORMALIZE_PADDING);
+	}
+	memmove(&m_block[0], m_end - keep, keep);
+	ssize_t len;
+	do {
+		// Returns what is available rather than waiting to fill the block,
+		// so words are checked as they arrive
+		len = read(m_fd, &m_block[keep], READ_BLOCK_BYTES - keep);
+	} while (len < 0 && errno == EINTR);
+	m_pos = m_block.data() + keep;
+	m_end = m_pos + std::max<ssize_t>(len, 0);
+	m_readable_end = m_block.data() + m_block.size();
+	return len > 0;
+}
+
+string_view FileReader::getWordView() {
 	while(1) { // Break by 'return' only when a word is found
-		if(!m_line_reader) {
-			string line;
-			if(!getline(m_file,line)) {
-				return "";
+		while (m_pos != m_end && isSpace(*m_pos)) {
+			++m_pos;
+		}
+		if (m_pos == m_end) {
+			if (!nextBlock(0)) {
+				return string_view();
 			}
-			m_line_reader = std::istringstream(line);
+			continue;
 		}
-		string word;
-		m_line_reader >> word;
-		word = processWord(word);
-		if (word != "") {
+		const char* start = m_pos;
+		while (1) {
+			while (m_pos != m_end && !isSpace(*m_pos)) {
+				++m_pos;
+			}
+			// A token at the end of a block may go on in the next one
+			size_t len = m_pos - start;
+			if (m_pos != m_end || m_mapped || m_fd < 0 || len >= MAX_TOKEN_LENGTH) {
+				break;
+			}
+			// Moves the token to the front of the block, even at end of file
+			bool more = nextBlock(len);
+			start = m_block.data();
+			if (!more) {
+				break;
+			}
+		}
+		string_view word = processWord(start, m_pos);
+		if (!word.empty()) {
 			return word;
 		}
 	}
 }
 
-string FileReader::processWord(string str) {
-	// Erase non alphanumeric characters
-	str.erase(std::remove_if(str.begin(), str.end(),
-		std::not1(std::ptr_fun((int(*)(int))std::isalpha))), str.end());
-	// covert to lower case
-	std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-	return str;
+string_view FileReader::processWord(const char* start, const char* end) {
+	size_t len = end - start;
+	if (static_cast<size_t>(m_readable_end - end) < NORMALIZE_PADDING) {
+		m_padded_token.assign(start, len);
+		m_padded_token.resize(len + NORMALIZE_PADDING);
+		start = m_padded_token.data();
+	}
+	if (m_word.size() < len + NORMALIZE_PADDING) {
+		m_word.resize(len + NORMALIZE_PADDING);
+	}
+	return string_view(m_word.data(), normalize(start, len, m_word.data()));
 }
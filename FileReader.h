@@ -2,22 +2,82 @@
 #ifndef FILEREADER_H
 #define FILEREADER_H
 
+#include <memory>
 #include <string>
-#include <tuple>
-#include <sstream>
-#include <fstream>
+#include <string_view>
 
+#include "MappedFile.h"
+
+/**
+ * Splits a file into words: runs of non-whitespace characters, stripped of
+ * non-alphabetic characters and lowercased. Words left empty are skipped.
+ * Regular files are memory-mapped and scanned in place. Other files (e.g.
+ * pipes) are read a block at a time, as much as is available, into a reused
+ * buffer, so each word is returned as soon as the whitespace after it is
+ * read. A token longer than MAX_TOKEN_LENGTH in such a file is split. Either
+ * way, reading a word does not allocate memory.
+ * Words are normalized by the fastest vectorized kernel the CPU supports.
+ */
 class FileReader final {
 public:
+	// Longest token of a file which is not mapped, bounding the memory kept
+	// for a token split across blocks
+	static constexpr size_t MAX_TOKEN_LENGTH = 4096;
+
 	FileReader(std::string path);
+
+	// Reads the words in bytes [begin, end) of a mapped file. The range must
+	// start and end at whitespace boundaries, and file must outlive the reader
+	FileReader(const MappedFile& file, size_t begin, size_t end);
+
+	// Reads the words of a text in memory, which must outlive the reader
+	FileReader(std::string_view text);
 	~FileReader();
+
+	// First position at or after pos where a range of file may start or end:
+	// after a whitespace character, or the end of the file
+	static size_t nextBoundary(const MappedFile& file, size_t pos);
+
+	// Next word, or "" at end of file
 	std::string getWord();
 
+	// Next word, or an empty view at end of file. The view is valid until the
+	// next call
+	std::string_view getWordView();
+
 private:
-	static std::string processWord(std::string str);
+	// Normalizes the token [start, end) into m_word, returning a view of it
+	std::string_view processWord(const char* start, const char* end);
+
+	// Reads the next block of a file which is not mapped into m_block, after
+	// the last keep bytes before m_end (the start of a token), which are
+	// moved to its front. False at end of file or on a read error
+	bool nextBlock(size_t keep);
+
+	// Mapping of the file, if it could be mapped
+	std::unique_ptr<MappedFile> m_mapping;
+
+	// True iff reading from memory, either m_mapping or a range of a mapping
+	// owned by the caller
+	bool m_mapped;
+
+	// Used when the file could not be mapped, -1 if it could not be opened
+	int m_fd;
+	std::string m_block;
+
+	// Unread part of the mapping or of m_block
+	const char* m_pos;
+	const char* m_end;
+
+	// End of the memory which may be read past m_end. The normalization
+	// kernels read whole vectors, possibly past the end of a token
+	const char* m_readable_end;
+
+	// Copy of a token too close to m_readable_end, padded for the kernels
+	std::string m_padded_token;
 
-	std::ifstream m_file;
-	std::istringstream m_line_reader;
+	// Buffer of the normalized word
+	std::string m_word;
 };
 
 #endif
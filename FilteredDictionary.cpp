@@ -0,0 +1,47 @@
+
+#include "FilteredDictionary.h"
+
+using std::string, std::string_view;
+
+FilteredDictionary::FilteredDictionary(std::unique_ptr<Dictionary> dict, string_hash_t hash_func, double false_positive_rate)
+	: m_dict(std::move(dict))
+	, m_filter(hash_func, m_dict->size(), false_positive_rate) {
+	m_dict->forEachWord([this](const string& word) {
+		m_filter.insert(word);
+	});
+}
+
+FilteredDictionary::~FilteredDictionary() {}
+
+const BloomFilter& FilteredDictionary::filter() const {
+	return m_filter;
+}
+
+bool FilteredDictionary::lookup(string_view word) const {
+	return m_filter.mayContain(word) && m_dict->lookup(word);
+}
+
+uint64_t FilteredDictionary::lookupMany(const string_view* words, size_t count) const {
+	// Only pass the words the filter does not reject to the dictionary
+	uint64_t maybe = m_filter.mayContainMany(words, count);
+	string_view passed[MAX_BATCH];
+	size_t num_passed = 0;
+	for (uint64_t bits = maybe; bits; bits &= bits - 1) {
+		passed[num_passed++] = words[__builtin_ctzll(bits)];
+	}
+	uint64_t found = num_passed ? m_dict->lookupMany(passed, num_passed) : 0;
+	// Scatter the results back to the positions of the passed words
+	uint64_t res = 0;
+	for (uint64_t bits = maybe; bits; bits &= bits - 1, found >>= 1) {
+		res |= (found & 1) << __builtin_ctzll(bits);
+	}
+	return res;
+}
+
+size_t FilteredDictionary::size() const {
+	return m_dict->size();
+}
+
+void FilteredDictionary::forEachWord(word_func_t func) const {
+	m_dict->forEachWord(func);
+}
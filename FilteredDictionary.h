@@ -0,0 +1,35 @@
+
+#ifndef FILTEREDDICTIONARY_H
+#define FILTEREDDICTIONARY_H
+
+#include <memory>
+
+#include "BloomFilter.h"
+#include "Dictionary.h"
+
+/**
+ * A dictionary fronted by a Bloom filter of its words. Most words which are
+ * not in the dictionary - the common case for Autocorrect's candidates - are
+ * rejected by the filter, in a single cache line access, before reaching the
+ * dictionary itself.
+ */
+class FilteredDictionary final : public Dictionary {
+public:
+	// Builds a filter of the words of dict, with the given false positive
+	// rate, hashing with hash_func
+	FilteredDictionary(std::unique_ptr<Dictionary> dict, string_hash_t hash_func, double false_positive_rate);
+	~FilteredDictionary();
+
+	const BloomFilter& filter() const;
+
+	bool lookup(std::string_view word) const override;
+	uint64_t lookupMany(const std::string_view* words, size_t count) const override;
+	size_t size() const override;
+	void forEachWord(word_func_t func) const override;
+
+private:
+	std::unique_ptr<Dictionary> m_dict;
+	BloomFilter m_filter;
+};
+
+#endif
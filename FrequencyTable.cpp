@@ -0,0 +1,67 @@
+
+#include <fstream>
+#include <sstream>
+
+#include "Exceptions.h"
+#include "FrequencyTable.h"
+#include "normalize.h"
+
+using std::string, std::string_view;
+
+// Typical number of words in a frequency file
+constexpr size_t FREQUENCY_WORDS_HINT = 64*1024;
+
+FrequencyTable::Entry::operator string_view() const {
+	return word;
+}
+
+bool FrequencyTable::Entry::operator==(string_view other) const {
+	return word == other;
+}
+
+FrequencyTable::FrequencyTable(string_hash_t hash_func, string path)
+	: m_table(hash_func, FREQUENCY_WORDS_HINT) {
+	std::ifstream in(path);
+	if (!in) {
+		throw FileError("Cannot open '" + path + "'");
+	}
+	static const normalize_func_t normalize = bestNormalizer();
+	string line, token, word;
+	uint64_t count;
+	size_t line_num = 0;
+	while (std::getline(in, line)) {
+		++line_num;
+		std::istringstream fields(line);
+		if (!(fields >> token)) {
+			continue;
+		}
+		if (!(fields >> count)) {
+			throw FileError("Malformed line " + std::to_string(line_num) + " in '" + path + "'");
+		}
+		// The kernels read and write past the token, within the padding
+		token.append(NORMALIZE_PADDING, ' ');
+		word.resize(token.length() + NORMALIZE_PADDING);
+		word.resize(normalize(token.data(), token.length() - NORMALIZE_PADDING, word.data()));
+		if (word.empty()) {
+			continue;
+		}
+		size_t hash = hash_func(word);
+		if (const Entry* entry = m_table.find(word, hash)) {
+			entry->count += count;
+		}
+		else {
+			m_table.insert(Entry{word, count}, hash);
+		}
+	}
+}
+
+FrequencyTable::~FrequencyTable() {}
+
+uint64_t FrequencyTable::frequency(string_view word) const {
+	const Entry* entry = m_table.find(word);
+	return entry ? entry->count : 0;
+}
+
+size_t FrequencyTable::size() const {
+	return m_table.size();
+}
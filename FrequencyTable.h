@@ -0,0 +1,45 @@
+
+#ifndef FREQUENCYTABLE_H
+#define FREQUENCYTABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Hashtable.h"
+#include "hash.h"
+
+/**
+ * Number of occurrences of words in some corpus, ranking suggestions.
+ * Read from a text file of lines "<word> <count>". Words are normalized as
+ * the words of checked files are (non alphabetic characters dropped,
+ * lowercased), and the counts of words normalized alike are summed.
+ */
+class FrequencyTable final {
+public:
+	// Reads the frequency file at path, hashing words with hash_func. Throws
+	// FileError if it cannot be read or a line is malformed
+	FrequencyTable(string_hash_t hash_func, std::string path);
+	~FrequencyTable();
+
+	// Count of a word, 0 if it is not in the table
+	uint64_t frequency(std::string_view word) const;
+
+	// Number of words in the table
+	size_t size() const;
+
+private:
+	// A word and its count, kept in the hash table and looked up by word
+	struct Entry final {
+		std::string word;
+		// Not part of the key, so it may change in the table
+		mutable uint64_t count;
+
+		operator std::string_view() const;
+		bool operator==(std::string_view other) const;
+	};
+
+	Hashtable<Entry, std::string_view> m_table;
+};
+
+#endif
@@ -0,0 +1,61 @@
+
+#include "HashDictionary.h"
+
+using std::string, std::string_view;
+
+HashDictionary::HashDictionary(string_hash_t hash_func, size_t expected_count, size_t num_shards)
+	: m_hash_func(hash_func) {
+	for (size_t i = 0; i < num_shards; ++i) {
+		m_shards.push_back(std::make_unique<Hashtable<string, string_view>>(
+			hash_func, expected_count / num_shards));
+	}
+}
+
+HashDictionary::~HashDictionary() {}
+
+void HashDictionary::insert(string word) {
+	size_t hash = m_hash_func(word);
+	insert(std::move(word), hash);
+}
+
+size_t HashDictionary::shardOf(size_t hash) const {
+	// Hash tables pick slots by the low bits and tags by the high bits of a
+	// hash, so pick shards by the middle bits
+	return (hash >> (sizeof(size_t)*4)) & (m_shards.size() - 1);
+}
+
+void HashDictionary::insert(string word, size_t hash) {
+	m_shards[shardOf(hash)]->insert(std::move(word), hash);
+}
+
+bool HashDictionary::lookup(string_view word) const {
+	size_t hash = m_hash_func(word);
+	return m_shards[shardOf(hash)]->lookup(word, hash);
+}
+
+uint64_t HashDictionary::lookupMany(const string_view* words, size_t count) const {
+	size_t hashes[MAX_BATCH];
+	for (size_t i = 0; i < count; ++i) {
+		hashes[i] = m_hash_func(words[i]);
+		m_shards[shardOf(hashes[i])]->prefetch(hashes[i]);
+	}
+	uint64_t res = 0;
+	for (size_t i = 0; i < count; ++i) {
+		res |= static_cast<uint64_t>(m_shards[shardOf(hashes[i])]->lookup(words[i], hashes[i])) << i;
+	}
+	return res;
+}
+
+size_t HashDictionary::size() const {
+	size_t res = 0;
+	for (const auto& shard : m_shards) {
+		res += shard->size();
+	}
+	return res;
+}
+
+void HashDictionary::forEachWord(word_func_t func) const {
+	for (const auto& shard : m_shards) {
+		shard->forEach(func);
+	}
+}
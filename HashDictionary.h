@@ -0,0 +1,47 @@
+
+#ifndef HASHDICTIONARY_H
+#define HASHDICTIONARY_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Dictionary.h"
+#include "Hashtable.h"
+#include "hash.h"
+
+/**
+ * Dictionary kept in in-memory hash tables, built word by word.
+ * Words are split between shards (independent hash tables) by their hash, so
+ * that several threads may fill different shards at the same time.
+ */
+class HashDictionary final : public Dictionary {
+public:
+	// Construct an empty dictionary sized for 'expected_count' words,
+	// hashing them with hash_func, split into num_shards shards (a power of 2)
+	HashDictionary(string_hash_t hash_func, size_t expected_count, size_t num_shards = 1);
+	~HashDictionary();
+
+	// Adds a word. Throws KeyAlreadyExists if it is already in the dictionary
+	void insert(std::string word);
+
+	// Shard of a word, by its hash
+	size_t shardOf(size_t hash) const;
+
+	// Adds a word whose hash was already computed by the hash function.
+	// Threads may call this concurrently for different shards.
+	// Throws KeyAlreadyExists if it is already in the dictionary
+	void insert(std::string word, size_t hash);
+
+	bool lookup(std::string_view word) const override;
+	uint64_t lookupMany(const std::string_view* words, size_t count) const override;
+	size_t size() const override;
+	void forEachWord(word_func_t func) const override;
+
+private:
+	string_hash_t m_hash_func;
+	std::vector<std::unique_ptr<Hashtable<std::string, std::string_view>>> m_shards;
+};
+
+#endif
@@ -2,65 +2,167 @@
 #ifndef HASHTABLE_H
 #define HASHTABLE_H
 
-#include <list>
+#include <cstdint>
 #include <vector>
 #include <functional>
 
 #include "Exceptions.h"
 
 /**
- * This class is a a template implementation of a hashtable using user given 
+ * This class is a a template implementation of a hashtable using user given
  * hash function.
- * Collisions are solved via appending keys to a list in the relevant hash
- * table entry.
+ * Collisions are solved via open addressing with linear probing. Keys are
+ * stored inline in a flat array of slots, next to a parallel array of one
+ * byte control words. A control word is either EMPTY, or holds the top 7 bits
+ * of the hash of the key in the slot, so a probe scans the (dense, cache
+ * friendly) control array and only compares keys whose hash tag matches -
+ * the same idea as Google's SwissTable.
+ * The table is sized from the expected number of keys, and doubles its
+ * capacity when the load factor passes 7/8. Growing is incremental: the keys
+ * of the old slots are moved to the new ones a few at a time on each insert,
+ * so no single insert pays for rehashing the whole table. Until all are
+ * moved, lookups search both.
+ * Keys are looked up by type K, which defaults to T. A lighter type may be
+ * used (e.g. std::string_view for std::string keys) so lookups do not need to
+ * construct a T; T must then convert to K, and compare with it.
  */
-template <class T>
+template <class T, class K = T>
 class Hashtable final {
 private:
-	// Entry in the hash table
-	class Entry;
+	// Slots of the hash table, either the current or the one being migrated
+	class Table;
 
 public:
-	// hash function turning objects of type T into hashes
-	using hash_func_t = std::function<size_t(T)>;
+	// hash function turning keys into hashes
+	using hash_func_t = std::function<size_t(const K&)>;
+
+	// Most keys of a lookupMany call, one per bit of its result
+	static constexpr size_t MAX_BATCH = 64;
 
 	// Construct an empty hash table using hash_func as hashing function
-	// and of size 'size'.
-	Hashtable(hash_func_t hash_func, size_t size);
+	// and sized to hold 'expected_count' keys before growing.
+	Hashtable(hash_func_t hash_func, size_t expected_count);
 	~Hashtable();
 
 	// Adds a key to the hash table
 	void insert(T key);
 
+	// Adds a key whose hash was already computed by the hash function
+	void insert(T key, size_t hash);
+
 	// Check whether a key is in the hash table
-	bool lookup(T key) const;
+	bool lookup(const K& key) const;
+
+	// Check whether a key whose hash was already computed by the hash
+	// function is in the hash table
+	bool lookup(const K& key, size_t hash) const;
+
+	// The key in the hash table equal to key, or nullptr if there is none.
+	// Valid until the next insert
+	const T* find(const K& key) const;
+
+	// Same as find, for a key whose hash was already computed by the hash
+	// function
+	const T* find(const K& key, size_t hash) const;
+
+	// Check whether each of count (at most MAX_BATCH) keys is in the hash table:
+	// bit i of the result is set iff keys[i] is. Prefetches the slots of all
+	// keys before probing any, so the cache misses overlap
+	uint64_t lookupMany(const K* keys, size_t count) const;
+
+	// Starts loading the slots a lookup of a key with this hash would probe
+	// first into the cache
+	void prefetch(size_t hash) const;
+
+	// Number of keys in the hash table
+	size_t size() const;
+
+	// Call func with every key in the hash table, in no particular order
+	void forEach(std::function<void(const T&)> func) const;
 
 private:
+	// Load factor limit, as a fraction of MAX_LOAD_DENOM
+	static constexpr size_t MAX_LOAD_NUM = 7;
+	static constexpr size_t MAX_LOAD_DENOM = 8;
+
+	// Number of old slots migrated on each insert while growing. Must be
+	// large enough for the migration to end before the new table fills up
+	static constexpr size_t MIGRATION_STEP = 8;
+
+	// Starts growing into a table of double capacity
+	void grow();
+
+	// Moves the keys of the next MIGRATION_STEP old slots to the new table
+	void migrate();
+
 	// hash function
 	hash_func_t m_hash_func;
 
-	// Table linking hashed to entries
-	std::vector<Entry> m_table;
+	// Table receiving inserts
+	Table m_table;
 
-	// size of hash table
-	size_t m_size;
+	// Table being migrated into m_table. Empty when not growing
+	Table m_old_table;
+
+	// Next slot of m_old_table to be migrated
+	size_t m_migrated;
+
+	// Number of keys in both tables
+	size_t m_count;
 };
 
-template <class T>
-class Hashtable<T>::Entry final {
+template <class T, class K>
+class Hashtable<T, K>::Table final {
 public:
-	Entry();
-	~Entry();
+	// Control word of a slot that has never been used
+	static constexpr uint8_t EMPTY = 0x80;
 
-	// Insert a new key to the hash table
-	void insert(T key);
+	// Control word of a slot whose key was moved to another table. Probes
+	// continue past it, as past a full slot
+	static constexpr uint8_t MOVED = 0x81;
+
+	// Construct a table of 'capacity' slots, a power of 2 (or 0)
+	Table(size_t capacity);
+	Table(Table&& other);
+	Table& operator=(Table&& other);
+	~Table();
+
+	// Extract the 7 bits tag kept in the control array from a hash
+	static uint8_t tagOf(size_t hash);
+
+	// Find slot holding key, or the empty slot ending its probe sequence
+	size_t find(const K& key, size_t hash) const;
+
+	// Check whether a slot holds a key
+	bool isFull(size_t idx) const;
 
-	// Check whether a certain key is in the table
-	bool lookup(T key) const;
+	// Key in a full slot
+	const T& at(size_t idx) const;
+	T& at(size_t idx);
+
+	// Put key in the empty slot ending its probe sequence. Key must not be
+	// in the table
+	void put(T key, size_t hash);
+
+	// Moves the key out of a full slot, marking it MOVED
+	T take(size_t idx);
+
+	// Starts loading the first slot probed for hash into the cache
+	void prefetch(size_t hash) const;
+
+	size_t capacity() const;
 
 private:
-	// List of keys with current hash
-	std::list<T> m_keys;
+	// Control words, one per slot
+	std::vector<uint8_t> m_ctrl;
+
+	// Keys, stored inline. Raw memory, where a key is constructed only in
+	// full slots - so allocating a large table does not construct a T for
+	// each slot
+	T* m_slots;
+
+	// capacity - 1
+	size_t m_mask;
 };
 
 #include "Hashtable.hpp"
@@ -2,47 +2,250 @@
 #ifndef HASHTABLE_HPP
 #define HASHTABLE_HPP
 
-template <class T>
-Hashtable<T>::Entry::Entry() {}
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <utility>
 
-template <class T>
-Hashtable<T>::Entry::~Entry() {}
+// Smallest power of 2 not smaller than n (and not smaller than 8)
+inline size_t roundUpPow2(size_t n) {
+	size_t res = 8;
+	while (res < n) {
+		res <<= 1;
+	}
+	return res;
+}
 
-template <class T>
-void Hashtable<T>::Entry::insert(T key) {
-	auto it = std::find(m_keys.begin(), m_keys.end(), key);
-	if (it != m_keys.end()) {
-		throw KeyAlreadyExists();
+template <class T, class K>
+Hashtable<T, K>::Table::Table(size_t capacity)
+	: m_ctrl(capacity, EMPTY)
+	, m_slots(capacity > 0 ? std::allocator<T>().allocate(capacity) : nullptr)
+	, m_mask(capacity - 1) {}
+
+template <class T, class K>
+Hashtable<T, K>::Table::Table(Table&& other)
+	: m_ctrl(std::move(other.m_ctrl))
+	, m_slots(other.m_slots)
+	, m_mask(other.m_mask) {
+	other.m_ctrl.clear();
+	other.m_slots = nullptr;
+}
+
+template <class T, class K>
+typename Hashtable<T, K>::Table& Hashtable<T, K>::Table::operator=(Table&& other) {
+	std::swap(m_ctrl, other.m_ctrl);
+	std::swap(m_slots, other.m_slots);
+	std::swap(m_mask, other.m_mask);
+	return *this;
+}
+
+template <class T, class K>
+Hashtable<T, K>::Table::~Table() {
+	for (size_t i = 0; i < capacity(); ++i) {
+		if (isFull(i)) {
+			std::destroy_at(&m_slots[i]);
+		}
+	}
+	if (m_slots) {
+		std::allocator<T>().deallocate(m_slots, capacity());
+	}
+}
+
+template <class T, class K>
+uint8_t Hashtable<T, K>::Table::tagOf(size_t hash) {
+	// The low bits pick the slot, so take the tag from the high bits
+	return static_cast<uint8_t>(hash >> (sizeof(size_t)*8 - 7));
+}
+
+template <class T, class K>
+size_t Hashtable<T, K>::Table::find(const K& key, size_t hash) const {
+	uint8_t tag = tagOf(hash);
+	size_t idx = hash & m_mask;
+	// Load factor is kept below 1, so an empty slot is always found
+	while (m_ctrl[idx] != EMPTY) {
+		if (m_ctrl[idx] == tag && m_slots[idx] == key) {
+			return idx;
+		}
+		idx = (idx + 1) & m_mask;
+	}
+	return idx;
+}
+
+template <class T, class K>
+bool Hashtable<T, K>::Table::isFull(size_t idx) const {
+	return m_ctrl[idx] != EMPTY && m_ctrl[idx] != MOVED;
+}
+
+template <class T, class K>
+void Hashtable<T, K>::Table::put(T key, size_t hash) {
+	// No need to compare keys, we know key is not in the table
+	size_t idx = hash & m_mask;
+	while (m_ctrl[idx] != EMPTY) {
+		idx = (idx + 1) & m_mask;
 	}
-	m_keys.push_back(key);
+	m_ctrl[idx] = tagOf(hash);
+	new (&m_slots[idx]) T(std::move(key));
+}
+
+template <class T, class K>
+const T& Hashtable<T, K>::Table::at(size_t idx) const {
+	return m_slots[idx];
+}
+
+template <class T, class K>
+T& Hashtable<T, K>::Table::at(size_t idx) {
+	return m_slots[idx];
 }
 
-template <class T>
-bool Hashtable<T>::Entry::lookup(T key) const {
-	auto it = std::find(m_keys.begin(), m_keys.end(), key);
-	return it != m_keys.end();
+template <class T, class K>
+T Hashtable<T, K>::Table::take(size_t idx) {
+	T key = std::move(m_slots[idx]);
+	std::destroy_at(&m_slots[idx]);
+	m_ctrl[idx] = MOVED;
+	return key;
 }
 
-template <class T>
-Hashtable<T>::Hashtable(typename Hashtable<T>::hash_func_t hash_func, size_t size)
+template <class T, class K>
+void Hashtable<T, K>::Table::prefetch(size_t hash) const {
+	if (capacity() > 0) {
+		size_t idx = hash & m_mask;
+		__builtin_prefetch(&m_ctrl[idx]);
+		__builtin_prefetch(&m_slots[idx]);
+	}
+}
+
+template <class T, class K>
+size_t Hashtable<T, K>::Table::capacity() const {
+	return m_ctrl.size();
+}
+
+template <class T, class K>
+Hashtable<T, K>::Hashtable(typename Hashtable<T, K>::hash_func_t hash_func, size_t expected_count)
 	: m_hash_func(hash_func)
-	, m_table(size)
-	, m_size(size) {}
+	, m_table(roundUpPow2(expected_count / MAX_LOAD_NUM * MAX_LOAD_DENOM + 1))
+	, m_old_table(0)
+	, m_migrated(0)
+	, m_count(0) {}
 
-template <class T>
-Hashtable<T>::~Hashtable() {}
+template <class T, class K>
+Hashtable<T, K>::~Hashtable() {}
 
+template <class T, class K>
+void Hashtable<T, K>::grow() {
+	m_old_table = Table(2 * m_table.capacity());
+	std::swap(m_table, m_old_table);
+	m_migrated = 0;
+}
 
-template <class T>
-void Hashtable<T>::insert(T key) {
-	size_t hash = m_hash_func(key);
-	m_table[hash % m_size].insert(key);
+template <class T, class K>
+void Hashtable<T, K>::migrate() {
+	size_t end = std::min(m_migrated + MIGRATION_STEP, m_old_table.capacity());
+	for (; m_migrated < end; ++m_migrated) {
+		if (m_old_table.isFull(m_migrated)) {
+			size_t hash = m_hash_func(m_old_table.at(m_migrated));
+			m_table.put(m_old_table.take(m_migrated), hash);
+		}
+	}
+	if (m_migrated == m_old_table.capacity()) {
+		// Done, release the old slots
+		m_old_table = Table(0);
+	}
 }
 
-template <class T>
-bool Hashtable<T>::lookup(T key) const {
+template <class T, class K>
+void Hashtable<T, K>::insert(T key) {
 	size_t hash = m_hash_func(key);
-	return m_table[hash % m_size].lookup(key);
+	insert(std::move(key), hash);
+}
+
+template <class T, class K>
+void Hashtable<T, K>::insert(T key, size_t hash) {
+	if (m_table.isFull(m_table.find(key, hash))) {
+		throw KeyAlreadyExists();
+	}
+	if (m_old_table.capacity() > 0) {
+		if (m_old_table.isFull(m_old_table.find(key, hash))) {
+			throw KeyAlreadyExists();
+		}
+		migrate();
+	}
+	else if ((m_count+1) * MAX_LOAD_DENOM > m_table.capacity() * MAX_LOAD_NUM) {
+		grow();
+		migrate();
+	}
+	m_table.put(std::move(key), hash);
+	++m_count;
+}
+
+template <class T, class K>
+bool Hashtable<T, K>::lookup(const K& key) const {
+	return lookup(key, m_hash_func(key));
+}
+
+template <class T, class K>
+bool Hashtable<T, K>::lookup(const K& key, size_t hash) const {
+	if (m_table.isFull(m_table.find(key, hash))) {
+		return true;
+	}
+	return m_old_table.capacity() > 0 && m_old_table.isFull(m_old_table.find(key, hash));
+}
+
+template <class T, class K>
+const T* Hashtable<T, K>::find(const K& key) const {
+	return find(key, m_hash_func(key));
+}
+
+template <class T, class K>
+const T* Hashtable<T, K>::find(const K& key, size_t hash) const {
+	size_t idx = m_table.find(key, hash);
+	if (m_table.isFull(idx)) {
+		return &m_table.at(idx);
+	}
+	if (m_old_table.capacity() > 0) {
+		idx = m_old_table.find(key, hash);
+		if (m_old_table.isFull(idx)) {
+			return &m_old_table.at(idx);
+		}
+	}
+	return nullptr;
+}
+
+template <class T, class K>
+uint64_t Hashtable<T, K>::lookupMany(const K* keys, size_t count) const {
+	assert(count <= MAX_BATCH);
+	size_t hashes[MAX_BATCH];
+	for (size_t i = 0; i < count; ++i) {
+		hashes[i] = m_hash_func(keys[i]);
+		prefetch(hashes[i]);
+	}
+	uint64_t res = 0;
+	for (size_t i = 0; i < count; ++i) {
+		res |= static_cast<uint64_t>(lookup(keys[i], hashes[i])) << i;
+	}
+	return res;
+}
+
+template <class T, class K>
+void Hashtable<T, K>::prefetch(size_t hash) const {
+	m_table.prefetch(hash);
+	m_old_table.prefetch(hash);
+}
+
+template <class T, class K>
+size_t Hashtable<T, K>::size() const {
+	return m_count;
+}
+
+template <class T, class K>
+void Hashtable<T, K>::forEach(std::function<void(const T&)> func) const {
+	for (const Table* table : {&m_table, &m_old_table}) {
+		for (size_t i = 0; i < table->capacity(); ++i) {
+			if (table->isFull(i)) {
+				func(table->at(i));
+			}
+		}
+	}
 }
 
 #endif
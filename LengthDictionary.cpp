@@ -0,0 +1,191 @@
+
+#include <cstring>
+
+#include "Exceptions.h"
+#include "LengthDictionary.h"
+
+using std::string, std::string_view, std::vector;
+
+// A word of up to INLINE_LENGTH letters, zero padded to 64 bits. Loads the
+// first and last 4 bytes, or 3 single bytes, which overlap for short words
+static uint64_t packed(string_view word) {
+	const char* data = word.data();
+	size_t length = word.length();
+	if (length >= 4) {
+		uint32_t first, last;
+		memcpy(&first, data, 4);
+		memcpy(&last, data + length - 4, 4);
+		return first | static_cast<uint64_t>(last) << (length - 4) * 8;
+	}
+	if (length == 0) {
+		return 0;
+	}
+	return static_cast<uint64_t>(static_cast<unsigned char>(data[0]))
+		| static_cast<uint64_t>(static_cast<unsigned char>(data[length / 2])) << (length / 2) * 8
+		| static_cast<uint64_t>(static_cast<unsigned char>(data[length - 1])) << (length - 1) * 8;
+}
+
+// Hash of a packed word (a multiply-xorshift mix)
+static size_t mixed(uint64_t key) {
+	key *= 0x9e3779b97f4a7c15;
+	return key ^ (key >> 32);
+}
+
+LengthDictionary::LengthDictionary(const Dictionary& dict, string_hash_t hash_func)
+	: m_hash_func(hash_func)
+	, m_size(0) {
+	vector<vector<string>> words_by_length;
+	dict.forEachWord([&](const string& word) {
+		if (word.empty()) {
+			return;
+		}
+		if (word.length() >= words_by_length.size()) {
+			words_by_length.resize(word.length() + 1);
+		}
+		words_by_length[word.length()].push_back(word);
+	});
+	m_partitions.resize(words_by_length.size());
+	for (size_t length = 1; length < words_by_length.size(); ++length) {
+		auto& words = words_by_length[length];
+		if (words.empty()) {
+			continue;
+		}
+		// Keep load factor at most 1/2, misses are the common case for Autocorrect
+		size_t num_slots = 8;
+		while (num_slots < 2*words.size()) {
+			num_slots <<= 1;
+		}
+		Partition& partition = m_partitions[length];
+		partition.slots.assign(num_slots, 0);
+		partition.mask = num_slots - 1;
+		if (length > INLINE_LENGTH) {
+			if (words.size() >= UINT32_MAX) {
+				throw InvalidIndex("Dictionary is too large to be partitioned by length");
+			}
+			partition.chars.reserve(words.size() * length);
+		}
+		for (const auto& word : words) {
+			if (!lookup(partition, word, hashOf(word))) {
+				insert(partition, word);
+			}
+		}
+		vector<string>().swap(words);
+	}
+}
+
+LengthDictionary::~LengthDictionary() {}
+
+size_t LengthDictionary::numPartitions() const {
+	size_t res = 0;
+	for (const auto& partition : m_partitions) {
+		res += partition.num_words > 0;
+	}
+	return res;
+}
+
+size_t LengthDictionary::sizeBytes() const {
+	size_t res = m_partitions.size() * sizeof(Partition);
+	for (const auto& partition : m_partitions) {
+		res += partition.slots.size() * sizeof(uint64_t) + partition.chars.capacity();
+	}
+	return res;
+}
+
+const LengthDictionary::Partition* LengthDictionary::partitionOf(string_view word) const {
+	if (word.length() >= m_partitions.size() || m_partitions[word.length()].num_words == 0) {
+		return nullptr;
+	}
+	return &m_partitions[word.length()];
+}
+
+size_t LengthDictionary::hashOf(string_view word) const {
+	return word.length() <= INLINE_LENGTH ? mixed(packed(word)) : m_hash_func(word);
+}
+
+void LengthDictionary::insert(Partition& partition, const string& word) {
+	size_t word_hash = hashOf(word);
+	size_t idx = word_hash & partition.mask;
+	while (partition.slots[idx] != 0) {
+		idx = (idx + 1) & partition.mask;
+	}
+	if (word.length() <= INLINE_LENGTH) {
+		partition.slots[idx] = packed(word);
+	}
+	else {
+		partition.slots[idx] = (word_hash >> 32) << 32 | (partition.num_words + 1);
+		partition.chars += word;
+	}
+	++partition.num_words;
+	++m_size;
+}
+
+bool LengthDictionary::lookup(string_view word) const {
+	const Partition* partition = partitionOf(word);
+	return partition && lookup(*partition, word, hashOf(word));
+}
+
+uint64_t LengthDictionary::lookupMany(const string_view* words, size_t count) const {
+	const Partition* partitions[MAX_BATCH];
+	size_t hashes[MAX_BATCH];
+	for (size_t i = 0; i < count; ++i) {
+		partitions[i] = partitionOf(words[i]);
+		if (partitions[i]) {
+			hashes[i] = hashOf(words[i]);
+			__builtin_prefetch(&partitions[i]->slots[hashes[i] & partitions[i]->mask]);
+		}
+	}
+	uint64_t res = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (partitions[i]) {
+			res |= static_cast<uint64_t>(lookup(*partitions[i], words[i], hashes[i])) << i;
+		}
+	}
+	return res;
+}
+
+bool LengthDictionary::lookup(const Partition& partition, string_view word, size_t word_hash) const {
+	size_t idx = word_hash & partition.mask;
+	if (word.length() <= INLINE_LENGTH) {
+		uint64_t key = packed(word);
+		for (uint64_t slot = partition.slots[idx]; slot != 0; slot = partition.slots[idx]) {
+			if (slot == key) {
+				return true;
+			}
+			idx = (idx + 1) & partition.mask;
+		}
+		return false;
+	}
+	uint64_t tag = word_hash >> 32;
+	for (uint64_t slot = partition.slots[idx]; slot != 0; slot = partition.slots[idx]) {
+		if (slot >> 32 == tag) {
+			size_t offset = ((slot & UINT32_MAX) - 1) * word.length();
+			if (memcmp(partition.chars.data() + offset, word.data(), word.length()) == 0) {
+				return true;
+			}
+		}
+		idx = (idx + 1) & partition.mask;
+	}
+	return false;
+}
+
+size_t LengthDictionary::size() const {
+	return m_size;
+}
+
+void LengthDictionary::forEachWord(word_func_t func) const {
+	for (size_t length = 1; length < m_partitions.size(); ++length) {
+		const Partition& partition = m_partitions[length];
+		if (length <= INLINE_LENGTH) {
+			for (uint64_t slot : partition.slots) {
+				if (slot != 0) {
+					func(string(reinterpret_cast<const char*>(&slot), length));
+				}
+			}
+		}
+		else {
+			for (size_t offset = 0; offset < partition.chars.length(); offset += length) {
+				func(partition.chars.substr(offset, length));
+			}
+		}
+	}
+}
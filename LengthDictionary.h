@@ -0,0 +1,77 @@
+
+#ifndef LENGTHDICTIONARY_H
+#define LENGTHDICTIONARY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Dictionary.h"
+#include "hash.h"
+
+/**
+ * Dictionary partitioned by word length, each partition its own compact
+ * open-addressing table. Autocorrect's candidates all have a known length,
+ * so each lookup only touches the table of that length: lengths without
+ * words are rejected before hashing, and the tables of common lengths are
+ * small enough to stay in cache.
+ * A word of up to 8 letters is kept in its slot, zero padded to 64 bits, so
+ * it is hashed and compared as a single integer. Longer words are kept
+ * back to back at a fixed stride in a characters blob, and a slot holds the
+ * high bits of the word's hash and its index in the blob.
+ */
+class LengthDictionary final : public Dictionary {
+public:
+	// Copies the words of dict, hashing words longer than 8 letters with
+	// hash_func
+	LengthDictionary(const Dictionary& dict, string_hash_t hash_func);
+	~LengthDictionary();
+
+	// Number of lengths with words
+	size_t numPartitions() const;
+
+	// Memory used by the partitions in bytes
+	size_t sizeBytes() const;
+
+	bool lookup(std::string_view word) const override;
+	uint64_t lookupMany(const std::string_view* words, size_t count) const override;
+	size_t size() const override;
+	void forEachWord(word_func_t func) const override;
+
+private:
+	// Longest word kept in its slot
+	static constexpr size_t INLINE_LENGTH = sizeof(uint64_t);
+
+	// The words of a single length
+	struct Partition final {
+		// Open addressing table, 0 for an empty slot. Either a word zero
+		// padded to 64 bits, or (hash tag << 32) | (index in chars + 1)
+		std::vector<uint64_t> slots;
+		// Words longer than INLINE_LENGTH, back to back
+		std::string chars;
+		size_t mask = 0;
+		size_t num_words = 0;
+	};
+
+	// Partition of the length of word, or nullptr if none has words
+	const Partition* partitionOf(std::string_view word) const;
+
+	// Hash of a word, picking its slot in its partition
+	size_t hashOf(std::string_view word) const;
+
+	// Check whether a word whose hash was already computed is in its
+	// partition
+	bool lookup(const Partition& partition, std::string_view word, size_t word_hash) const;
+
+	// Adds a word of a partition which is not in it yet
+	void insert(Partition& partition, const std::string& word);
+
+	string_hash_t m_hash_func;
+
+	// Partitions by length, up to the longest word
+	std::vector<Partition> m_partitions;
+	size_t m_size;
+};
+
+#endif
@@ -0,0 +1,68 @@
+
+#ifndef LRUCACHE_H
+#define LRUCACHE_H
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * A bounded map from keys to values, which evicts the least recently used
+ * entry when full. Entries are kept in a list in order of use, most recent
+ * first, and indexed by a hash map of list positions, so all operations take
+ * constant time.
+ * Counts the hits and misses of get().
+ */
+template <class K, class V>
+class LruCache final {
+public:
+	// Construct an empty cache of up to capacity entries
+	LruCache(size_t capacity);
+	~LruCache();
+
+	// Value of key, or nullptr if it is not cached. A found entry becomes
+	// the most recently used. The pointer is valid until the next put()
+	const V* get(const K& key);
+
+	// Whether key is cached, without using the entry or counting a hit or
+	// miss
+	bool contains(const K& key) const;
+
+	// Caches the value of a key as the most recently used entry, replacing
+	// its previous value if cached, and evicting the least recently used
+	// entry if full
+	void put(K key, V value);
+
+	// Call func with every entry, least recently used first - so putting
+	// them in this order into an empty cache restores the same order
+	void forEach(std::function<void(const K&, const V&)> func) const;
+
+	// Number of cached entries
+	size_t size() const;
+
+	size_t capacity() const;
+
+	// Number of get() calls which found their key, and which did not
+	size_t hits() const;
+	size_t misses() const;
+
+private:
+	using entry_t = std::pair<K, V>;
+	using entries_t = std::list<entry_t>;
+
+	size_t m_capacity;
+
+	// Entries, most recently used first
+	entries_t m_entries;
+
+	// Position of each key in m_entries
+	std::unordered_map<K, typename entries_t::iterator> m_index;
+
+	size_t m_hits;
+	size_t m_misses;
+};
+
+#include "LruCache.hpp"
+
+#endif
@@ -0,0 +1,83 @@
+
+#ifndef LRUCACHE_HPP
+#define LRUCACHE_HPP
+
+template <class K, class V>
+LruCache<K, V>::LruCache(size_t capacity)
+	: m_capacity(capacity)
+	, m_hits(0)
+	, m_misses(0) {
+	m_index.reserve(capacity);
+}
+
+template <class K, class V>
+LruCache<K, V>::~LruCache() {}
+
+template <class K, class V>
+const V* LruCache<K, V>::get(const K& key) {
+	auto found = m_index.find(key);
+	if (found == m_index.end()) {
+		++m_misses;
+		return nullptr;
+	}
+	++m_hits;
+	m_entries.splice(m_entries.begin(), m_entries, found->second);
+	return &found->second->second;
+}
+
+template <class K, class V>
+bool LruCache<K, V>::contains(const K& key) const {
+	return m_index.find(key) != m_index.end();
+}
+
+template <class K, class V>
+void LruCache<K, V>::put(K key, V value) {
+	if (m_capacity == 0) {
+		return;
+	}
+	auto found = m_index.find(key);
+	if (found != m_index.end()) {
+		found->second->second = std::move(value);
+		m_entries.splice(m_entries.begin(), m_entries, found->second);
+		return;
+	}
+	if (m_entries.size() == m_capacity) {
+		// Reuse the list node of the evicted entry
+		m_index.erase(m_entries.back().first);
+		m_entries.splice(m_entries.begin(), m_entries, std::prev(m_entries.end()));
+		m_entries.front() = entry_t(std::move(key), std::move(value));
+	}
+	else {
+		m_entries.emplace_front(std::move(key), std::move(value));
+	}
+	m_index.emplace(m_entries.front().first, m_entries.begin());
+}
+
+template <class K, class V>
+void LruCache<K, V>::forEach(std::function<void(const K&, const V&)> func) const {
+	for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it) {
+		func(it->first, it->second);
+	}
+}
+
+template <class K, class V>
+size_t LruCache<K, V>::size() const {
+	return m_entries.size();
+}
+
+template <class K, class V>
+size_t LruCache<K, V>::capacity() const {
+	return m_capacity;
+}
+
+template <class K, class V>
+size_t LruCache<K, V>::hits() const {
+	return m_hits;
+}
+
+template <class K, class V>
+size_t LruCache<K, V>::misses() const {
+	return m_misses;
+}
+
+#endif
@@ -0,0 +1,55 @@
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Exceptions.h"
+#include "MappedFile.h"
+
+using std::string;
+
+MappedFile::MappedFile(string path)
+	: m_data(nullptr)
+	, m_size(0) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw FileError("Cannot open '" + path + "'");
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		throw FileError("'" + path + "' is not a regular file");
+	}
+	m_size = st.st_size;
+	if (m_size > 0) {
+		void* addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED) {
+			close(fd);
+			throw FileError("Cannot map '" + path + "'");
+		}
+		m_data = static_cast<const char*>(addr);
+	}
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if (m_data) {
+		munmap(const_cast<char*>(m_data), m_size);
+	}
+}
+
+const char* MappedFile::data() const {
+	return m_data;
+}
+
+size_t MappedFile::size() const {
+	return m_size;
+}
+
+void MappedFile::adviseSequential() const {
+	if (m_data) {
+		madvise(const_cast<char*>(m_data), m_size, MADV_SEQUENTIAL);
+	}
+}
@@ -0,0 +1,35 @@
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+
+/**
+ * A read-only memory mapping of a whole file, unmapped on destruction.
+ */
+class MappedFile final {
+public:
+	// Maps the file at path. Throws FileError on failure, or if it is not a
+	// regular file
+	MappedFile(std::string path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Start of the mapped file (nullptr for an empty file)
+	const char* data() const;
+
+	// Size of the mapped file in bytes
+	size_t size() const;
+
+	// Hint the kernel that the file will be read sequentially, so it reads
+	// ahead aggressively
+	void adviseSequential() const;
+
+private:
+	const char* m_data;
+	size_t m_size;
+};
+
+#endif
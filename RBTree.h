@@ -4,6 +4,7 @@
 
 #include <memory>
 #include <functional>
+#include <vector>
 
 #include "Exceptions.h"
 
@@ -20,14 +21,14 @@ enum class direction {
 
 /**
  * A template implementation of a red-black binary tree.
- * The implementation uses smart pointers instead of regular C-style pointers
- * to allow greater verbosity.
- * Each node has a weak_ptr reference to it's parent and a shared_ptr to it's
- * childern. Assuming there are not other pointers to it's children, deleting
- * a node - or a whole tree - is as simple as resetting the pointer to it or
- * having it's pointer get out of scope.
- * The nodes has to keep an element to the tree object. To allow this,
- * creation of a tree object is allowed only via the createTree function
+ * Nodes are allocated from an arena owned by the tree: chunks of nodes of
+ * growing size, with killed nodes kept on a free list for reuse. Nodes link
+ * to each other with raw pointers and hold their key inline, so inserting a
+ * key costs at most one allocation per chunk, and walking the tree costs no
+ * reference counting.
+ * All leaves are a single shared NIL sentinel node, which is also the parent
+ * of the root (as in CLRS). Deleting the tree releases all nodes at once.
+ * Creation of a tree object is allowed only via the createTree function
  * whom returns a shared_ptr to a newly created tree. This law is enforced
  * by requiring a private-typed empty struct as a parameter to the constructor
  * which will be optimized away by the compiler.
@@ -43,15 +44,16 @@ private:
 
 public:
     // Type for key comparer function
-    using comp_func_t = std::function<int(T, T)>;
-    
+    using comp_func_t = std::function<int(const T&, const T&)>;
+
     // Do not call this method - create a tree via the createTree function
-    // instead. The nodes of the tree needs to have a pointer to it, however
-    // as we are using smart pointers we need to create a shared_ptr to current
-    // object. Nodes will hold it as weak_ptr
+    // instead.
     RBTree(comp_func_t, ctor_protector_t);
     ~RBTree();
 
+    RBTree(const RBTree&) = delete;
+    RBTree& operator=(const RBTree&) = delete;
+
     // Creates an empty tree with comp_func as key comparison function
     static std::shared_ptr<RBTree<T>> createTree(comp_func_t comp_func);
 
@@ -59,14 +61,57 @@ public:
     void insert(T key);
 
     // Removes a key from the tree
-    void remove(T key);
+    void remove(const T& key);
 
-    // Finds minimal node in tree
-    std::shared_ptr<RBNode> minimum();
+    // Finds minimal node in tree (the NIL node if the tree is empty)
+    RBNode* minimum();
 
 private:
+    // Number of nodes in the first arena chunk. Each chunk doubles in size
+    static constexpr size_t FIRST_CHUNK_SIZE = 64;
+
+    // Takes a node from the free list or the arena
+    RBNode* allocNode();
+
+    // Returns a node removed from the tree to the free list
+    void freeNode(RBNode* node);
+
+    // Replaces subtree rooted at u with subtree rooted at v
+    void transplant(RBNode* u, RBNode* v);
+
+    // Rotates the subtree rooted at node in direction dir
+    void rotate(RBNode* node, direction dir);
+
+    // Restores red-black properties after inserting a red node
+    void insertFixup(RBNode* node);
+
+    // Removes a node having at most one non-NIL child from the tree
+    void erase(RBNode* node);
+
+    // Restores red-black properties after removing a black node, whose
+    // place was taken by node
+    void eraseFixup(RBNode* node);
+
+    // Node with given key, or NIL if there is none
+    RBNode* find(const T& key);
+
+    // Arena chunks
+    std::vector<std::unique_ptr<RBNode[]>> m_chunks;
+
+    // Number of nodes handed out of the last chunk
+    size_t m_chunk_used;
+
+    // Size of the last chunk
+    size_t m_chunk_size;
+
+    // Killed nodes, linked by their parent pointer
+    RBNode* m_free;
+
+    // Shared NIL sentinel
+    RBNode* m_nil;
+
     // Root of the tree
-    std::shared_ptr<RBNode> m_root;
+    RBNode* m_root;
 
     // Key comparison function
     comp_func_t m_comp_func;
@@ -75,69 +120,46 @@ private:
 template <class T>
 class RBTree<T>::RBNode final {
 public:
-    RBNode(std::weak_ptr<RBTree<T>> tree);
+    RBNode();
     ~RBNode();
 
-    // Inserts a key to subtree under curent node
-    void insert(T key);
-    
-    // Removes current node from tree. WARNING: you must hold a shared_ptr to
-    // current node when calling this, otherwise node may be destroyed 
-    // mid-execution when ref count reaches 0.
+    // Removes current node from tree.
     // Returns succcessor node (usefull to allow iterating and deleting nodes)
-    std::shared_ptr<RBNode> kill();
+    RBNode* kill();
 
     // Find successor node
-    std::shared_ptr<RBNode> succ() const;
-    
+    RBNode* succ() const;
+
     // Find predecessor node
-    std::shared_ptr<RBNode> pred() const;
-    
+    RBNode* pred() const;
+
     // Find successor/predecessor node in given direction
-    std::shared_ptr<RBNode> scan(direction dir) const;
-    
+    RBNode* scan(direction dir) const;
+
     // Find minimal keyed node
-    std::shared_ptr<RBNode> minimum() const;
-    
+    RBNode* minimum() const;
+
     // Get child in chosen direction
-    std::shared_ptr<RBNode> getChild(direction dir) const;
-    
+    RBNode* getChild(direction dir) const;
+
     // Finds whether this is a left or right child
     direction getDirectionFromParent() const;
 
     // True iff this is a Nil
     bool isNil() const;
 
-    // Create a new node to be added to a tree
-    static std::shared_ptr<RBNode> createNode(std::weak_ptr<RBTree<T>> tree);
-
     // Returns current node value
     const T& get() const;
 
-    // Create child of current node
-    std::shared_ptr<RBNode> createChild();
-
 private:
-    // Try to turn a node red rebalance tree
-    void redden();
-
-    // Try to add black height to current node
-    void blacken();
-
-    // Rotates tree
-    void rotate(direction dir);
+    friend class RBTree<T>;
 
     color m_color;
-    std::weak_ptr<RBTree<T>> m_tree; // pointer to tree object
-    std::weak_ptr<RBNode> m_self; // weak ptr to self. Used to pass to children nodes
-    std::weak_ptr<RBNode> m_p; // parent. Weak ptr to prevent memory leak upon deletion
-    std::shared_ptr<RBNode> m_l; // left child
-    std::shared_ptr<RBNode> m_r; // right child
-
-    // A unique_ptr to current node's key. Used to check whether a node is Nil 
-    // (nullptr iff node is Nil)
-    std::unique_ptr<T> m_key;
-
+    RBTree<T>* m_tree; // tree owning this node
+    RBNode* m_p; // parent. NIL for the root
+    RBNode* m_l; // left child. nullptr iff this is the NIL node
+    RBNode* m_r; // right child. nullptr iff this is the NIL node
+    T m_key;
 };
 
 // Implementation
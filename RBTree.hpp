@@ -11,137 +11,82 @@ inline direction flip(direction orig) {
 
 template <class T>
 std::shared_ptr<RBTree<T>> RBTree<T>::createTree(comp_func_t comp_func) {
-    auto tree = std::make_shared<RBTree<T>>(comp_func, ctor_protector_t());
-    tree->m_root = RBNode::createNode(tree);
-    return tree;
+    return std::make_shared<RBTree<T>>(comp_func, ctor_protector_t());
 }
 
 template <class T>
-RBTree<T>::RBNode::RBNode(std::weak_ptr<RBTree<T>> tree)
+RBTree<T>::RBNode::RBNode()
     : m_color(color::BLACK)
-    , m_tree(tree) {}
+    , m_tree(nullptr)
+    , m_p(nullptr)
+    , m_l(nullptr)
+    , m_r(nullptr) {}
 
 template <class T>
-RBTree<T>::RBNode::~RBNode() {
-    // Delete all children by shared_ptr magic
-}
-
-template <class T>
-std::shared_ptr<typename RBTree<T>::RBNode> RBTree<T>::RBNode::createNode(std::weak_ptr<RBTree<T>> tree) {
-    auto node = std::make_shared<RBNode>(tree);
-    node->m_self = node;
-    return node;
-}
-
-template <class T>
-std::shared_ptr<typename RBTree<T>::RBNode> RBTree<T>::RBNode::createChild() {
-    auto node = createNode(m_tree);
-    node->m_p = m_self;
-    return node;
-}
+RBTree<T>::RBNode::~RBNode() {}
 
 template <class T>
 bool RBTree<T>::RBNode::isNil() const {
-    return !m_key;
+    return !m_l;
 }
 
 template <class T>
-void RBTree<T>::RBNode::insert(T key) {
-    if (!m_key) {
-        m_key = std::make_unique<T>(key);
-        m_l = createChild();
-        m_r = createChild();
-        redden();
-        return;
-    }
-
-    int comp_res = m_tree.lock()->m_comp_func(key, *m_key);
-
-    if (comp_res == 0) {
-        throw KeyAlreadyExists();
-    }
-
-    if (comp_res > 0) {
-        m_r->insert(key);
-        return;
-    }
-    m_l->insert(key);
-}
-
-template <class T>
-std::shared_ptr<typename RBTree<T>::RBNode> RBTree<T>::RBNode::kill() {
-     std::shared_ptr<RBNode> retval = succ();
-    auto killed_node = m_self.lock();
-    if (m_r->m_key && m_l->m_key) {
-        killed_node = retval; // retval is the successor
-        retval = m_self.lock();
+typename RBTree<T>::RBNode* RBTree<T>::RBNode::kill() {
+    RBNode* retval = succ();
+    RBNode* killed_node = this;
+    if (!m_l->isNil() && !m_r->isNil()) {
+        // The successor has no left child - remove it instead, moving its key
+        // here
+        killed_node = retval;
+        retval = this;
         m_key = std::move(killed_node->m_key);
     }
-    auto replacing_node = killed_node->m_l->m_key ? killed_node->m_l : killed_node->m_r;
-    auto killed_node_parent = killed_node->m_p.lock();
-    if (!killed_node_parent) {
-        // killed node is root
-        m_tree.lock()->m_root = replacing_node;
-    }
-    else {
-        auto killed_node_dir = killed_node->getDirectionFromParent();
-        if (killed_node_dir == direction::LEFT) {
-            killed_node_parent->m_l = replacing_node;
-        }
-        else {
-            killed_node_parent->m_r = replacing_node;
-        }
-    }
-    replacing_node->m_p = killed_node_parent;
-    if (killed_node->m_color == color::BLACK) {
-        replacing_node->blacken();
-    }
+    m_tree->erase(killed_node);
     return retval;
 }
 
 template <class T>
-std::shared_ptr<typename RBTree<T>::RBNode> RBTree<T>::RBNode::succ() const {
+typename RBTree<T>::RBNode* RBTree<T>::RBNode::succ() const {
     return scan(direction::RIGHT);
 }
 
 template <class T>
-std::shared_ptr<typename RBTree<T>::RBNode> RBTree<T>::RBNode::pred() const {
+typename RBTree<T>::RBNode* RBTree<T>::RBNode::pred() const {
     return scan(direction::LEFT);
 }
 
 template <class T>
-std::shared_ptr<typename RBTree<T>::RBNode> RBTree<T>::RBNode::scan(direction dir) const {
-    auto ptr = getChild(dir);
-    if (ptr && ptr->m_key) {
+typename RBTree<T>::RBNode* RBTree<T>::RBNode::scan(direction dir) const {
+    RBNode* ptr = getChild(dir);
+    if (!ptr->isNil()) {
         // There is a child in the scanned direction, therefore successor is in subtree
-        while(ptr->m_key) {
+        while (!ptr->getChild(flip(dir))->isNil()) {
             // progress as much as possible in opposite direction in subtree
             ptr = ptr->getChild(flip(dir));
         }
-        // Now we reached a leaf without a value, returning direct parent
-        return ptr->m_p.lock();
-    }
-    ptr = m_self.lock();
-    while (ptr->m_p.lock() && ptr->getDirectionFromParent() == dir) {
-        ptr = ptr->m_p.lock();
-    }
-    if (!ptr) {
         return ptr;
     }
+    const RBNode* cur = this;
+    ptr = m_p;
+    while (!ptr->isNil() && ptr->getChild(dir) == cur) {
+        cur = ptr;
+        ptr = ptr->m_p;
+    }
     // return either the direct parent, or if this is the last node - a nullptr
-    return ptr->m_p.lock();
+    return ptr->isNil() ? nullptr : ptr;
 }
 
 template <class T>
-std::shared_ptr<typename RBTree<T>::RBNode> RBTree<T>::RBNode::minimum() const {
-    if (!m_l || !m_l->m_key) {
-        return m_self.lock();
+typename RBTree<T>::RBNode* RBTree<T>::RBNode::minimum() const {
+    const RBNode* ptr = this;
+    while (!ptr->isNil() && !ptr->m_l->isNil()) {
+        ptr = ptr->m_l;
     }
-    return m_l->minimum();
+    return const_cast<RBNode*>(ptr);
 }
 
 template <class T>
-std::shared_ptr<typename RBTree<T>::RBNode> RBTree<T>::RBNode::getChild(direction dir) const {
+typename RBTree<T>::RBNode* RBTree<T>::RBNode::getChild(direction dir) const {
     if (dir == direction::LEFT) {
         return m_l;
     }
@@ -150,182 +95,246 @@ std::shared_ptr<typename RBTree<T>::RBNode> RBTree<T>::RBNode::getChild(directio
 
 template <class T>
 direction RBTree<T>::RBNode::getDirectionFromParent() const {
-    auto p = m_p.lock();
-    if (!p) {
+    if (m_p->isNil()) {
         throw std::runtime_error("Root node is looking for parent!");
     }
-    if (p->m_l == m_self.lock()) {
+    if (m_p->m_l == this) {
         return direction::LEFT;
     }
-    if (p->m_r == m_self.lock()) {
+    if (m_p->m_r == this) {
         return direction::RIGHT;
     }
     throw std::runtime_error("Parent does not know this node!");
 }
 
 template <class T>
-void RBTree<T>::RBNode::redden() {
-    // Implementing as recursion is easier in this case
-    // as we get free updates of `this`
-    auto p = m_p.lock();
-    if (!p) {
-        // root, update red height by one
-        m_color = color::BLACK;
-        return;
-    }
-    
-    m_color = color::RED;
-    if (p->m_color == color::BLACK) {
-        // All ok, can finish recursion
-        return;
-    }
+const T& RBTree<T>::RBNode::get() const {
+    return m_key;
+}
 
-    auto grandpa = p->m_p.lock();
-    auto parent_dir = p->getDirectionFromParent();
-    auto uncle = grandpa->getChild(flip(parent_dir));
+template <class T>
+RBTree<T>::RBTree(comp_func_t comp_func, ctor_protector_t ctor_protector)
+    : m_chunk_used(0)
+    , m_chunk_size(0)
+    , m_free(nullptr)
+    , m_nil(nullptr)
+    , m_comp_func(comp_func) {
+    // prevent warnings while not allow user to call Ctor
+    ctor_protector = ctor_protector;
+    m_nil = allocNode();
+    m_nil->m_color = color::BLACK;
+    m_nil->m_l = m_nil->m_r = nullptr;
+    m_nil->m_p = m_nil;
+    m_root = m_nil;
+}
 
-    // Case 1
-    if (uncle->m_color == color::RED) {
-        // Red uncle, color father and uncle black and pass reddening upwards
-        p->m_color = color::BLACK;
-        uncle->m_color = color::BLACK;
-        grandpa->redden();
-        return;
+template <class T>
+RBTree<T>::~RBTree() {
+    // Nodes are released with their chunks
+}
+
+template <class T>
+typename RBTree<T>::RBNode* RBTree<T>::allocNode() {
+    RBNode* node;
+    if (m_free) {
+        node = m_free;
+        m_free = node->m_p;
     }
-    
-    auto dir = getDirectionFromParent();
-        
-    // Case 2
-    if (dir != parent_dir) {
-        // Rotate into case 3
-        p->rotate(parent_dir);
-        p->redden();
-        return;
+    else {
+        if (m_chunk_used == m_chunk_size) {
+            m_chunk_size = m_chunk_size ? 2*m_chunk_size : FIRST_CHUNK_SIZE;
+            m_chunks.push_back(std::make_unique<RBNode[]>(m_chunk_size));
+            m_chunk_used = 0;
+        }
+        node = &m_chunks.back()[m_chunk_used++];
     }
-
-    // Case 3
-    p->m_color = color::BLACK;
-    grandpa->m_color = color::RED;
-    grandpa->rotate(flip(parent_dir));
+    node->m_tree = this;
+    node->m_color = color::RED;
+    node->m_p = node->m_l = node->m_r = m_nil;
+    return node;
 }
 
+template <class T>
+void RBTree<T>::freeNode(RBNode* node) {
+    node->m_p = m_free;
+    m_free = node;
+}
 
 template <class T>
-void RBTree<T>::RBNode::blacken() {
-    // More natural to implement using recursion
-    auto p = m_p.lock();
-    if (!p) {
-        // Node is root, decrease black height by one
-        return;
-    }
-    if (m_color == color::RED) {
-        // Blackening a red node is easy
-        m_color = color::BLACK;
-        return;
-    }
-    auto dir = getDirectionFromParent();
-    auto brother = p->getChild(flip(dir));
-    // Case 1
-    if (brother->m_color == color::RED) {
-        brother->m_color = color::BLACK;
-        p->m_color = color::RED;
-        p->rotate(dir);
-        // Move to black brother case
-        blacken();
-        return;
+void RBTree<T>::transplant(RBNode* u, RBNode* v) {
+    if (u->m_p->isNil()) {
+        m_root = v;
     }
-    // Black brother
-    // Case 2
-    if (brother->m_l->m_color == color::BLACK && brother->m_r->m_color == color::BLACK) {
-        // Both brother's kids are black
-        // color brother red, and move extra black upwards
-        brother->m_color = color::RED;
-        p->blacken();
-        return;
+    else if (u == u->m_p->m_l) {
+        u->m_p->m_l = v;
     }
-    // At least one kid of brother is red
-    // Case 3
-    if (brother->getChild(flip(dir))->m_color == color::BLACK) {
-        // Color same sided cousin in black and brother in red
-        // then rotate brother into opposing side cousin (red -> case 4)
-        brother->getChild(dir)->m_color = color::BLACK;
-        brother->m_color = color::RED;
-        brother->rotate(flip(dir));
-        blacken();
-        return;
+    else {
+        u->m_p->m_r = v;
     }
-    // The remaining case is red opposite sided cousin
-    // Case 4
-    // Switch colors between (black) brother and parent, rotating parent and
-    // adding a black node on both sides of new parent, rebalancing the tree
-    brother->m_color = p->m_color;
-    p->m_color = color::BLACK;
-    brother->getChild(flip(dir))->m_color = color::BLACK;
-    p->rotate(dir);
+    // Set even if v is NIL, eraseFixup relies on it
+    v->m_p = u->m_p;
 }
 
 template <class T>
-void RBTree<T>::RBNode::rotate(direction dir) {
-    auto new_parent = getChild(flip(dir));
-    if (!new_parent || !new_parent->m_key) {
+void RBTree<T>::rotate(RBNode* node, direction dir) {
+    RBNode* new_parent = node->getChild(flip(dir));
+    if (new_parent->isNil()) {
         throw std::runtime_error("Attempting to rotate a NIL into node!");
     }
-
-    auto old_parent = m_p.lock();
-    auto self = m_self.lock();
-    direction my_dir = direction::LEFT;
-    if (old_parent) {
-        my_dir = getDirectionFromParent();
+    // The inner subtree of new_parent moves under node
+    RBNode*& inner = dir == direction::LEFT ? new_parent->m_l : new_parent->m_r;
+    RBNode*& outer_slot = dir == direction::LEFT ? node->m_r : node->m_l;
+    outer_slot = inner;
+    if (!inner->isNil()) {
+        inner->m_p = node;
     }
-
-    m_p = new_parent;
-    new_parent->m_p = old_parent;
-    if (dir == direction::LEFT) {
-        m_r = new_parent->m_l;
-        m_r->m_p = self;
-        new_parent->m_l = self;
+    new_parent->m_p = node->m_p;
+    if (node->m_p->isNil()) {
+        m_root = new_parent;
+    }
+    else if (node == node->m_p->m_l) {
+        node->m_p->m_l = new_parent;
     }
     else {
-        m_l = new_parent->m_r;
-        m_l->m_p = self;
-        new_parent->m_r = self;
+        node->m_p->m_r = new_parent;
     }
-    if (old_parent) {
-        if (my_dir == direction::LEFT) {
-            old_parent->m_l = new_parent;
-        }
-        else {
-            old_parent->m_r = new_parent;
+    inner = node;
+    node->m_p = new_parent;
+}
+
+template <class T>
+void RBTree<T>::insert(T key) {
+    RBNode* parent = m_nil;
+    RBNode* ptr = m_root;
+    int comp_res = 0;
+    while (!ptr->isNil()) {
+        parent = ptr;
+        comp_res = m_comp_func(key, ptr->m_key);
+        if (comp_res == 0) {
+            throw KeyAlreadyExists();
         }
+        ptr = comp_res > 0 ? ptr->m_r : ptr->m_l;
+    }
+    RBNode* node = allocNode();
+    node->m_key = std::move(key);
+    node->m_p = parent;
+    if (parent->isNil()) {
+        m_root = node;
+    }
+    else if (comp_res > 0) {
+        parent->m_r = node;
     }
     else {
-        m_tree.lock()->m_root = new_parent;
+        parent->m_l = node;
     }
+    insertFixup(node);
 }
 
 template <class T>
-const T& RBTree<T>::RBNode::get() const {
-    return *m_key;
+void RBTree<T>::insertFixup(RBNode* node) {
+    while (node->m_p->m_color == color::RED) {
+        RBNode* p = node->m_p;
+        RBNode* grandpa = p->m_p;
+        direction parent_dir = p == grandpa->m_l ? direction::LEFT : direction::RIGHT;
+        RBNode* uncle = grandpa->getChild(flip(parent_dir));
+
+        // Case 1
+        if (uncle->m_color == color::RED) {
+            // Red uncle, color father and uncle black and pass reddening upwards
+            p->m_color = color::BLACK;
+            uncle->m_color = color::BLACK;
+            grandpa->m_color = color::RED;
+            node = grandpa;
+            continue;
+        }
+
+        // Case 2
+        if (node == p->getChild(flip(parent_dir))) {
+            // Rotate into case 3
+            node = p;
+            rotate(node, parent_dir);
+            p = node->m_p;
+        }
+
+        // Case 3
+        p->m_color = color::BLACK;
+        grandpa->m_color = color::RED;
+        rotate(grandpa, flip(parent_dir));
+    }
+    m_root->m_color = color::BLACK;
 }
 
 template <class T>
-RBTree<T>::RBTree(comp_func_t comp_func, ctor_protector_t ctor_protector)
-    : m_comp_func(comp_func) {
-    // prevent warnings while not allow user to call Ctor
-    ctor_protector = ctor_protector;
+void RBTree<T>::erase(RBNode* node) {
+    RBNode* replacing_node = node->m_l->isNil() ? node->m_r : node->m_l;
+    transplant(node, replacing_node);
+    if (node->m_color == color::BLACK) {
+        eraseFixup(replacing_node);
+    }
+    freeNode(node);
 }
 
 template <class T>
-RBTree<T>::~RBTree() {}
+void RBTree<T>::eraseFixup(RBNode* node) {
+    while (node != m_root && node->m_color == color::BLACK) {
+        RBNode* p = node->m_p;
+        direction dir = node == p->m_l ? direction::LEFT : direction::RIGHT;
+        RBNode* brother = p->getChild(flip(dir));
+        // Case 1
+        if (brother->m_color == color::RED) {
+            brother->m_color = color::BLACK;
+            p->m_color = color::RED;
+            rotate(p, dir);
+            // Move to black brother case
+            brother = p->getChild(flip(dir));
+        }
+        // Black brother
+        // Case 2
+        if (brother->m_l->m_color == color::BLACK && brother->m_r->m_color == color::BLACK) {
+            // Both brother's kids are black
+            // color brother red, and move extra black upwards
+            brother->m_color = color::RED;
+            node = p;
+            continue;
+        }
+        // At least one kid of brother is red
+        // Case 3
+        if (brother->getChild(flip(dir))->m_color == color::BLACK) {
+            // Color same sided cousin in black and brother in red
+            // then rotate brother into opposing side cousin (red -> case 4)
+            brother->getChild(dir)->m_color = color::BLACK;
+            brother->m_color = color::RED;
+            rotate(brother, flip(dir));
+            brother = p->getChild(flip(dir));
+        }
+        // Case 4
+        // Switch colors between (black) brother and parent, rotating parent and
+        // adding a black node on both sides of new parent, rebalancing the tree
+        brother->m_color = p->m_color;
+        p->m_color = color::BLACK;
+        brother->getChild(flip(dir))->m_color = color::BLACK;
+        rotate(p, dir);
+        node = m_root;
+    }
+    node->m_color = color::BLACK;
+}
 
 template <class T>
-void RBTree<T>::insert(T key) {
-    m_root->insert(key);
+typename RBTree<T>::RBNode* RBTree<T>::find(const T& key) {
+    RBNode* ptr = m_root;
+    while (!ptr->isNil()) {
+        int comp_res = m_comp_func(key, ptr->m_key);
+        if (comp_res == 0) {
+            return ptr;
+        }
+        ptr = comp_res > 0 ? ptr->m_r : ptr->m_l;
+    }
+    return ptr;
 }
 
 template <class T>
-void RBTree<T>::remove(T key) {
-    auto node = m_root->find(key);
+void RBTree<T>::remove(const T& key) {
+    auto node = find(key);
     if (node->isNil()) {
         throw KeyNotFound();
     }
@@ -333,7 +342,7 @@ void RBTree<T>::remove(T key) {
 }
 
 template <class T>
-std::shared_ptr<typename RBTree<T>::RBNode> RBTree<T>::minimum() {
+typename RBTree<T>::RBNode* RBTree<T>::minimum() {
     return m_root->minimum();
 }
 
@@ -0,0 +1,158 @@
+
+#include <cstdio>
+
+#include "Exceptions.h"
+#include "ReportWriter.h"
+
+using std::string;
+
+ReportWriter::Format ReportWriter::formatOf(const string& name) {
+	if (name == "text") {
+		return Format::TEXT;
+	}
+	if (name == "jsonl") {
+		return Format::JSONL;
+	}
+	throw InvalidOption("Unknown report format '" + name + "'");
+}
+
+ReportWriter::ReportWriter(std::ostream& out, std::ostream& log, Format format)
+	: m_out(out)
+	, m_log(log)
+	, m_format(format) {}
+
+ReportWriter::~ReportWriter() {}
+
+std::ostream& ReportWriter::progress() const {
+	return m_format == Format::TEXT ? m_out : m_log;
+}
+
+void ReportWriter::misspelled(const string& path, const string& word, size_t count,
+	const std::vector<Suggestion>& suggestions) {
+	if (m_format == Format::TEXT) {
+		m_out << word << '\n';
+		if (!suggestions.empty()) {
+			m_out << "Did you mean: ";
+			for (size_t i = 0; i < suggestions.size(); ++i) {
+				if (i > 0) {
+					m_out << (i + 1 == suggestions.size() ? " or " : ", ");
+				}
+				m_out << "'" << suggestions[i].word << "'";
+			}
+			m_out << "?\n";
+		}
+		return;
+	}
+	// The best suggestion and its strategy, then all of them in rank order
+	m_out << "{\"file\":";
+	writeJson(path);
+	m_out << ",\"word\":";
+	writeJson(word);
+	m_out << ",\"count\":";
+	if (count > 0) {
+		m_out << count;
+	}
+	else {
+		m_out << "null";
+	}
+	m_out << ",\"suggestion\":";
+	if (suggestions.empty()) {
+		m_out << "null,\"strategy\":null";
+	}
+	else {
+		writeJson(suggestions[0].word);
+		m_out << ",\"strategy\":";
+		writeJson(suggestions[0].strategy);
+	}
+	m_out << ",\"suggestions\":[";
+	for (size_t i = 0; i < suggestions.size(); ++i) {
+		m_out << (i > 0 ? ",{\"word\":" : "{\"word\":");
+		writeJson(suggestions[i].word);
+		m_out << ",\"strategy\":";
+		writeJson(suggestions[i].strategy);
+		m_out << '}';
+	}
+	m_out << "]}\n";
+}
+
+void ReportWriter::flush() {
+	m_out.flush();
+}
+
+// Length of the well formed UTF-8 sequence of a non-ASCII character at pos
+// of str, or 0 if it isn't one (overlong, surrogate, beyond U+10FFFF, or cut)
+static size_t utf8Length(const string& str, size_t pos) {
+	auto byte = [&](size_t i) {
+		return static_cast<unsigned char>(pos + i < str.length() ? str[pos + i] : 0);
+	};
+	unsigned char lead = byte(0);
+	size_t length;
+	// Range of the second byte, narrower after some leads
+	unsigned char low = 0x80, high = 0xbf;
+	if (lead >= 0xc2 && lead <= 0xdf) {
+		length = 2;
+	}
+	else if (lead >= 0xe0 && lead <= 0xef) {
+		length = 3;
+		if (lead == 0xe0) {
+			low = 0xa0;
+		}
+		else if (lead == 0xed) {
+			high = 0x9f;
+		}
+	}
+	else if (lead >= 0xf0 && lead <= 0xf4) {
+		length = 4;
+		if (lead == 0xf0) {
+			low = 0x90;
+		}
+		else if (lead == 0xf4) {
+			high = 0x8f;
+		}
+	}
+	else {
+		return 0;
+	}
+	if (byte(1) < low || byte(1) > high) {
+		return 0;
+	}
+	for (size_t i = 2; i < length; ++i) {
+		if (byte(i) < 0x80 || byte(i) > 0xbf) {
+			return 0;
+		}
+	}
+	return length;
+}
+
+void ReportWriter::writeJson(const string& str) {
+	m_out << '"';
+	for (size_t i = 0; i < str.length();) {
+		char c = str[i];
+		if (c == '"' || c == '\\') {
+			m_out << '\\' << c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20) {
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			m_out << escaped;
+		}
+		else if (static_cast<unsigned char>(c) >= 0x80) {
+			// Words and paths are bytes, which JSON can't hold unless UTF-8
+			size_t length = utf8Length(str, i);
+			if (length == 0) {
+				m_out << "\\ufffd";
+				++i;
+			}
+			else {
+				m_out.write(str.data() + i, length);
+				i += length;
+			}
+			continue;
+		}
+		else {
+			m_out << c;
+		}
+		++i;
+	}
+	m_out << '"';
+}
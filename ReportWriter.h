@@ -0,0 +1,57 @@
+
+#ifndef REPORTWRITER_H
+#define REPORTWRITER_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Writes the misspelled words of checked files and their suggestions to an
+ * output stream, ending lines with '\n' rather than std::endl so the stream
+ * is only flushed when its buffer fills, or on flush().
+ * The text format is the spell checker's usual report. The JSONL format
+ * writes a JSON object per misspelled word on a line of its own, and sends
+ * progress and statistics to a log stream instead, so that the output has
+ * nothing but JSON lines.
+ */
+class ReportWriter final {
+public:
+	enum class Format { TEXT, JSONL };
+
+	// A suggestion for a misspelled word
+	struct Suggestion final {
+		std::string word;
+		// Name of the strategy which found the word
+		std::string strategy;
+	};
+
+	// Format of a name, "text" or "jsonl". Throws InvalidOption for others
+	static Format formatOf(const std::string& name);
+
+	ReportWriter(std::ostream& out, std::ostream& log, Format format);
+	~ReportWriter();
+
+	// Stream of progress and statistics lines: the output stream in the
+	// text format, the log stream otherwise
+	std::ostream& progress() const;
+
+	// Writes a misspelled word of the file at path, seen count times in it
+	// (0 if not counted), and its suggestions
+	void misspelled(const std::string& path, const std::string& word, size_t count,
+		const std::vector<Suggestion>& suggestions);
+
+	// Flushes the output stream, e.g. once a streamed word is reported
+	void flush();
+
+private:
+	// Writes a string as a JSON string literal, invalid UTF-8 bytes as U+FFFD
+	void writeJson(const std::string& str);
+
+	std::ostream& m_out;
+	std::ostream& m_log;
+	Format m_format;
+};
+
+#endif
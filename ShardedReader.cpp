@@ -0,0 +1,66 @@
+
+#include <algorithm>
+#include <exception>
+
+#include "ShardedReader.h"
+
+size_t ShardedReader::numShards(size_t num_threads) {
+	size_t num_shards = 1;
+	while (num_shards < num_threads * SHARDS_PER_THREAD && num_threads > 1) {
+		num_shards <<= 1;
+	}
+	return num_shards;
+}
+
+ShardedReader::ShardedReader(ThreadPool& pool, const MappedFile& file, size_t num_chunks)
+	: m_pool(pool)
+	, m_file(file)
+	, m_num_shards(numShards(pool.numThreads())) {
+	num_chunks = std::max<size_t>(num_chunks, 1);
+	m_bounds.assign(num_chunks + 1, file.size());
+	m_bounds[0] = 0;
+	for (size_t i = 1; i < num_chunks; ++i) {
+		m_bounds[i] = FileReader::nextBoundary(file, std::max(m_bounds[i-1], file.size() / num_chunks * i));
+	}
+}
+
+ShardedReader::~ShardedReader() {}
+
+size_t ShardedReader::numChunks() const {
+	return m_bounds.size() - 1;
+}
+
+size_t ShardedReader::numShards() const {
+	return m_num_shards;
+}
+
+size_t ShardedReader::shardOf(size_t hash) const {
+	return (hash >> (sizeof(size_t)*4)) & (m_num_shards - 1);
+}
+
+void ShardedReader::read(const std::function<void(size_t chunk, FileReader& fr)>& read_chunk,
+	const std::function<void(size_t shard)>& merge_shard) {
+	runAll(numChunks(), [&](size_t chunk) {
+		FileReader fr(m_file, m_bounds[chunk], m_bounds[chunk+1]);
+		read_chunk(chunk, fr);
+	});
+	runAll(m_num_shards, merge_shard);
+}
+
+void ShardedReader::runAll(size_t count, const std::function<void(size_t i)>& func) {
+	// Calls on the pool must not throw
+	std::vector<std::exception_ptr> errors(count);
+	m_pool.parallelFor(count, [&](size_t, size_t i) {
+		try {
+			func(i);
+		}
+		catch (...) {
+			errors[i] = std::current_exception();
+		}
+	});
+	for (const auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
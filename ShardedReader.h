@@ -0,0 +1,63 @@
+
+#ifndef SHARDEDREADER_H
+#define SHARDEDREADER_H
+
+#include <functional>
+#include <vector>
+
+#include "FileReader.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+/**
+ * Reads the words of a mapped file on the threads of a pool, grouped into
+ * shards by hash, as dictionaries and large checked files are read.
+ * The file is split into chunks at whitespace. First, the words of each
+ * chunk are read on a thread, the caller partitioning them by shard. Then
+ * each shard is merged on a single thread from its partitions of all chunks,
+ * in file order - so the words of a shard are merged in the same order as
+ * when reading the file on a single thread.
+ */
+class ShardedReader final {
+public:
+	// Shards per thread, allowing some imbalance between shards
+	static constexpr size_t SHARDS_PER_THREAD = 4;
+
+	// Number of shards of words read on num_threads threads: a power of 2,
+	// 1 on a single thread
+	static size_t numShards(size_t num_threads);
+
+	// Splits file into num_chunks chunks (at least 1), read on the threads
+	// of pool. The file and pool must outlive the reader
+	ShardedReader(ThreadPool& pool, const MappedFile& file, size_t num_chunks);
+	~ShardedReader();
+
+	size_t numChunks() const;
+
+	// numShards() of the threads of the pool
+	size_t numShards() const;
+
+	// Shard of a word by its hash. Picked by the middle bits, as tables pick
+	// slots by the low bits
+	size_t shardOf(size_t hash) const;
+
+	// Calls read_chunk(chunk, fr) for each chunk, fr reading its words, then
+	// merge_shard(shard) for each shard. The calls are spread over the
+	// threads of the pool, and must not use the pool. The first exception
+	// thrown by any call is rethrown once all the calls of its step returned
+	void read(const std::function<void(size_t chunk, FileReader& fr)>& read_chunk,
+		const std::function<void(size_t shard)>& merge_shard);
+
+private:
+	// Calls func(i) for each i in [0, count) on the pool, rethrowing the
+	// first exception thrown once all returned
+	void runAll(size_t count, const std::function<void(size_t i)>& func);
+
+	ThreadPool& m_pool;
+	const MappedFile& m_file;
+	// Chunk i is [m_bounds[i], m_bounds[i+1])
+	std::vector<size_t> m_bounds;
+	size_t m_num_shards;
+};
+
+#endif
@@ -0,0 +1,247 @@
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Exceptions.h"
+#include "Socket.h"
+
+using std::string, std::string_view;
+
+// Address of the socket file at path
+static sockaddr_un addressOf(const string& path) {
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.length() >= sizeof(addr.sun_path)) {
+		throw SocketError("Socket path '" + path + "' is too long");
+	}
+	memcpy(addr.sun_path, path.c_str(), path.length() + 1);
+	return addr;
+}
+
+Socket::Socket(int fd)
+	: m_fd(fd) {}
+
+Socket::Socket(Socket&& other)
+	: m_fd(other.m_fd) {
+	other.m_fd = -1;
+}
+
+Socket::~Socket() {
+	if (m_fd >= 0) {
+		close(m_fd);
+	}
+}
+
+Socket Socket::connect(string path) {
+	sockaddr_un addr = addressOf(path);
+	Socket res(socket(AF_UNIX, SOCK_STREAM, 0));
+	if (res.m_fd < 0 || ::connect(res.m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+		throw SocketError("Cannot connect to '" + path + "': " + strerror(errno));
+	}
+	return res;
+}
+
+Socket Socket::listen(string path) {
+	sockaddr_un addr = addressOf(path);
+	// Only a socket is replaced, never a file given by mistake
+	struct stat st;
+	if (lstat(path.c_str(), &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			throw SocketError("Cannot listen on '" + path + "': not a socket");
+		}
+		unlink(path.c_str());
+	}
+	Socket res(socket(AF_UNIX, SOCK_STREAM, 0));
+	if (res.m_fd < 0 || bind(res.m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+		|| ::listen(res.m_fd, SOMAXCONN) != 0) {
+		throw SocketError("Cannot listen on '" + path + "': " + strerror(errno));
+	}
+	return res;
+}
+
+Socket Socket::accept() const {
+	for (;;) {
+		int fd = ::accept(m_fd, nullptr, nullptr);
+		if (fd >= 0) {
+			return Socket(fd);
+		}
+		if (errno != EINTR && errno != ECONNABORTED) {
+			throw SocketError(string("Cannot accept a client: ") + strerror(errno));
+		}
+	}
+}
+
+void Socket::setTimeout(std::chrono::milliseconds timeout) const {
+	timeval tv;
+	tv.tv_sec = timeout.count() / 1000;
+	tv.tv_usec = (timeout.count() % 1000) * 1000;
+	if (setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0
+		|| setsockopt(m_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0) {
+		throw SocketError(string("Cannot set a socket timeout: ") + strerror(errno));
+	}
+}
+
+void Socket::send(string_view message) const {
+	if (message.length() > MAX_MESSAGE) {
+		throw SocketError("Message too long");
+	}
+	uint32_t len = htonl(static_cast<uint32_t>(message.length()));
+	string frame(reinterpret_cast<const char*>(&len), sizeof(len));
+	frame += message;
+	for (size_t sent = 0; sent < frame.length();) {
+		// No SIGPIPE if the peer is gone, a server must outlive its clients
+		ssize_t res = ::send(m_fd, frame.data() + sent, frame.length() - sent, MSG_NOSIGNAL);
+		if (res < 0 && errno == EINTR) {
+			continue;
+		}
+		if (res <= 0) {
+			throw SocketError(string("Cannot send: ") + strerror(errno));
+		}
+		sent += res;
+	}
+}
+
+bool Socket::receive(string& message) const {
+	uint32_t len;
+	if (!readFully(reinterpret_cast<char*>(&len), sizeof(len))) {
+		return false;
+	}
+	len = ntohl(len);
+	if (len > MAX_MESSAGE) {
+		throw SocketError("Message too long");
+	}
+	message.resize(len);
+	if (len > 0 && !readFully(&message[0], len)) {
+		throw SocketError("Connection closed in the middle of a message");
+	}
+	return true;
+}
+
+bool Socket::readFully(char* data, size_t len) const {
+	for (size_t done = 0; done < len;) {
+		ssize_t res = read(m_fd, data + done, len - done);
+		if (res < 0 && errno == EINTR) {
+			continue;
+		}
+		if (res < 0) {
+			throw SocketError(string("Cannot receive: ") + strerror(errno));
+		}
+		if (res == 0) {
+			if (done == 0) {
+				return false;
+			}
+			throw SocketError("Connection closed in the middle of a message");
+		}
+		done += res;
+	}
+	return true;
+}
+
+// The poller stopped by SIGINT and SIGTERM, if any
+static ClientPoller* signal_poller = nullptr;
+
+ClientPoller::ClientPoller(const Socket& server)
+	: m_server(server)
+	, m_stopped(false)
+	, m_stops_on_signals(false) {
+	if (pipe2(m_wake, O_CLOEXEC | O_NONBLOCK) != 0) {
+		throw SocketError(string("Cannot create a pipe: ") + strerror(errno));
+	}
+}
+
+ClientPoller::~ClientPoller() {
+	if (m_stops_on_signals) {
+		signal(SIGINT, SIG_DFL);
+		signal(SIGTERM, SIG_DFL);
+		signal_poller = nullptr;
+	}
+	close(m_wake[0]);
+	close(m_wake[1]);
+}
+
+void ClientPoller::stopOnSignals() {
+	signal_poller = this;
+	m_stops_on_signals = true;
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = [](int) {
+		signal_poller->m_stopped = true;
+		signal_poller->wake();
+	};
+	// Other blocking calls go on, the thread in next() wakes up either way
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+}
+
+std::optional<Socket> ClientPoller::next() {
+	std::lock_guard<std::mutex> poll_lock(m_poll_mutex);
+	for (;;) {
+		if (m_stopped) {
+			return std::nullopt;
+		}
+		if (!m_ready.empty()) {
+			Socket client = std::move(m_ready.back());
+			m_ready.pop_back();
+			return client;
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_added_mutex);
+			for (auto& client : m_added) {
+				m_idle.push_back(std::move(client));
+			}
+			m_added.clear();
+		}
+		std::vector<pollfd> fds(m_idle.size() + 2);
+		fds[0] = {m_server.m_fd, POLLIN, 0};
+		fds[1] = {m_wake[0], POLLIN, 0};
+		for (size_t i = 0; i < m_idle.size(); ++i) {
+			fds[i + 2] = {m_idle[i].m_fd, POLLIN, 0};
+		}
+		if (poll(fds.data(), fds.size(), -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw SocketError(string("Cannot wait for clients: ") + strerror(errno));
+		}
+		if (fds[1].revents != 0) {
+			char buf[64];
+			while (read(m_wake[0], buf, sizeof(buf)) > 0) {}
+		}
+		// A hung up or failed client is ready too, its reader finds out
+		std::vector<Socket> idle;
+		for (size_t i = 0; i < m_idle.size(); ++i) {
+			(fds[i + 2].revents != 0 ? m_ready : idle).push_back(std::move(m_idle[i]));
+		}
+		m_idle.swap(idle);
+		if (fds[0].revents != 0) {
+			m_idle.push_back(m_server.accept());
+		}
+	}
+}
+
+void ClientPoller::add(Socket client) {
+	{
+		std::lock_guard<std::mutex> lock(m_added_mutex);
+		m_added.push_back(std::move(client));
+	}
+	wake();
+}
+
+void ClientPoller::wake() {
+	// A full pipe already wakes the waiting thread
+	int saved_errno = errno;
+	char byte = 0;
+	ssize_t res = write(m_wake[1], &byte, 1);
+	(void)res;
+	errno = saved_errno;
+}
@@ -0,0 +1,113 @@
+
+#ifndef SOCKET_H
+#define SOCKET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * A Unix domain stream socket exchanging length-prefixed messages: a 4 byte
+ * length in network byte order, followed by that many bytes. Closed on
+ * destruction.
+ */
+class Socket final {
+public:
+	// Largest message accepted, guarding against garbage lengths
+	static constexpr uint32_t MAX_MESSAGE = 64 << 20;
+
+	// Connects to a server listening at path. Throws SocketError on failure
+	static Socket connect(std::string path);
+
+	// Listens at path, replacing any socket file left there. Throws
+	// SocketError on failure, or if another kind of file is at path
+	static Socket listen(std::string path);
+
+	Socket(Socket&& other);
+	~Socket();
+
+	Socket(const Socket&) = delete;
+	Socket& operator=(const Socket&) = delete;
+
+	// Waits for the next client of a listening socket
+	Socket accept() const;
+
+	// Fails sending or receiving (with SocketError) after waiting timeout
+	// for the peer, so a stalled peer cannot hold its reader forever
+	void setTimeout(std::chrono::milliseconds timeout) const;
+
+	// Sends a message. Throws SocketError if the peer is gone
+	void send(std::string_view message) const;
+
+	// Receives the next message into message. False if the peer closed the
+	// connection between messages. Throws SocketError on a truncated or
+	// oversized message
+	bool receive(std::string& message) const;
+
+private:
+	explicit Socket(int fd);
+
+	// Reads exactly len bytes. False if the peer closed the connection
+	// before the first byte
+	bool readFully(char* data, size_t len) const;
+
+	int m_fd;
+
+	friend class ClientPoller;
+};
+
+/**
+ * The clients of a listening socket, waited on together so that an idle
+ * client holds no thread: a thread takes a client with a request, answers
+ * it, and hands the client back to wait for its next request. Any number
+ * of threads may take and hand back clients at a time.
+ */
+class ClientPoller final {
+public:
+	// Accepts the clients of server, which must outlive the poller. Throws
+	// SocketError on failure
+	explicit ClientPoller(const Socket& server);
+	~ClientPoller();
+
+	ClientPoller(const ClientPoller&) = delete;
+	ClientPoller& operator=(const ClientPoller&) = delete;
+
+	// Waits for a client with a request to receive (or which disconnected),
+	// accepting new clients meanwhile. Nothing once stopped. Throws
+	// SocketError if accepting a client fails
+	std::optional<Socket> next();
+
+	// Hands back a client to wait for its next request
+	void add(Socket client);
+
+	// Stops the poller on SIGINT or SIGTERM, instead of terminating the
+	// process, until the poller is destroyed. One poller at a time
+	void stopOnSignals();
+
+private:
+	// Wakes up the thread waiting in next(). Async signal safe
+	void wake();
+
+	const Socket& m_server;
+	// Pipe written to by wake()
+	int m_wake[2];
+	std::atomic<bool> m_stopped;
+	bool m_stops_on_signals;
+
+	// Held by the thread waiting in next(), which alone uses m_idle and
+	// m_ready
+	std::mutex m_poll_mutex;
+	std::vector<Socket> m_idle;
+	// Clients with a request found by the last wait, not taken yet
+	std::vector<Socket> m_ready;
+
+	std::mutex m_added_mutex;
+	std::vector<Socket> m_added;
+};
+
+#endif
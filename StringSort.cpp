@@ -0,0 +1,98 @@
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "StringSort.h"
+
+using std::string, std::swap;
+
+// Ranges this short are sorted by insertion sort
+constexpr ptrdiff_t INSERTION_SORT_MAX = 16;
+
+// A string being sorted. Sorting these small keys, instead of the strings
+// themselves, keeps swaps cheap
+struct Key final {
+	const char* data;
+	uint32_t length;
+	// Position of the string in the input
+	uint32_t idx;
+};
+
+// Character of key at depth, as the unsigned value std::string::compare
+// orders by, or -1 past its end (so shorter strings come first)
+static inline int charAt(const Key& key, size_t depth) {
+	return depth < key.length ? static_cast<unsigned char>(key.data[depth]) : -1;
+}
+
+// Compares the characters of two keys from depth on
+static inline bool lessFrom(const Key& a, const Key& b, size_t depth) {
+	size_t len = std::min(a.length, b.length);
+	int res = len > depth ? std::memcmp(a.data + depth, b.data + depth, len - depth) : 0;
+	return res < 0 || (res == 0 && a.length < b.length);
+}
+
+// Sorts n keys, all sharing their first depth characters
+static void insertionSort(Key* keys, ptrdiff_t n, size_t depth) {
+	for (ptrdiff_t i = 1; i < n; ++i) {
+		for (ptrdiff_t j = i; j > 0 && lessFrom(keys[j], keys[j-1], depth); --j) {
+			swap(keys[j], keys[j-1]);
+		}
+	}
+}
+
+// Median of three characters
+static inline int median(int a, int b, int c) {
+	if (a < b) {
+		return b < c ? b : (a < c ? c : a);
+	}
+	return a < c ? a : (b < c ? c : b);
+}
+
+// Sorts n keys, all sharing their first depth characters
+static void multikeySort(Key* keys, ptrdiff_t n, size_t depth) {
+	while (n > INSERTION_SORT_MAX) {
+		int pivot = median(charAt(keys[0], depth), charAt(keys[n/2], depth), charAt(keys[n-1], depth));
+		// Partition into [0, lt) < pivot, [lt, gt) == pivot, [gt, n) > pivot
+		ptrdiff_t lt = 0, i = 0, gt = n;
+		while (i < gt) {
+			int c = charAt(keys[i], depth);
+			if (c < pivot) {
+				swap(keys[lt++], keys[i++]);
+			}
+			else if (c > pivot) {
+				swap(keys[i], keys[--gt]);
+			}
+			else {
+				++i;
+			}
+		}
+		multikeySort(keys, lt, depth);
+		multikeySort(keys + gt, n - gt, depth);
+		if (pivot == -1) {
+			// The middle keys all end here, they are equal
+			return;
+		}
+		// The middle keys share one more character
+		keys += lt;
+		n = gt - lt;
+		++depth;
+	}
+	insertionSort(keys, n, depth);
+}
+
+void multikeySort(std::vector<string>& strs) {
+	std::vector<Key> keys(strs.size());
+	for (size_t i = 0; i < strs.size(); ++i) {
+		keys[i] = Key{strs[i].data(), static_cast<uint32_t>(strs[i].length()), static_cast<uint32_t>(i)};
+	}
+	multikeySort(keys.data(), keys.size(), 0);
+	std::vector<string> sorted;
+	sorted.reserve(strs.size());
+	for (const auto& key : keys) {
+		sorted.push_back(std::move(strs[key.idx]));
+	}
+	strs = std::move(sorted);
+}
@@ -0,0 +1,15 @@
+
+#ifndef STRINGSORT_H
+#define STRINGSORT_H
+
+#include <string>
+#include <vector>
+
+// Sorts strings in lexicographic order (the order of std::string::compare)
+// by multikey quicksort (Bentley & Sedgewick): a three way partition on one
+// character at a time, so common prefixes are compared only once, instead of
+// once per comparison as in a comparison sort. Strings must be shorter than
+// 4 GiB, and fewer than 2^32
+void multikeySort(std::vector<std::string>& strs);
+
+#endif
@@ -0,0 +1,33 @@
+
+#ifndef SUGGESTER_H
+#define SUGGESTER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Interface of a suggestion engine: an index of the dictionary words which
+ * finds all those within a Damerau-Levenshtein (optimal string alignment)
+ * distance of a misspelled word. Autocorrect falls back to one when its edit
+ * strategies find nothing.
+ */
+class Suggester {
+public:
+	// A dictionary word within the distance from a queried word
+	struct Match final {
+		std::string word;
+		size_t distance;
+	};
+
+	virtual ~Suggester() {}
+
+	// All dictionary words within max_distance (at most maxDistance()) from
+	// word, closest first, ties in lexicographic order
+	virtual std::vector<Match> find(std::string_view word, size_t max_distance) const = 0;
+
+	// Largest distance the engine supports
+	virtual size_t maxDistance() const = 0;
+};
+
+#endif
@@ -0,0 +1,130 @@
+
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t num_threads)
+	: m_func(nullptr)
+	, m_loop(0)
+	, m_num_running(0)
+	, m_stopping(false) {
+	num_threads = std::max<size_t>(num_threads, 1);
+	for (size_t i = 0; i < num_threads; ++i) {
+		m_ranges.push_back(std::make_unique<Range>());
+	}
+	for (size_t i = 1; i < num_threads; ++i) {
+		m_threads.emplace_back(&ThreadPool::threadMain, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_loop_started.notify_all();
+	for (auto& thread : m_threads) {
+		thread.join();
+	}
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t thread, size_t i)>& func) {
+	size_t num_threads = m_ranges.size();
+	for (size_t i = 0; i < num_threads; ++i) {
+		std::lock_guard<std::mutex> lock(m_ranges[i]->mutex);
+		m_ranges[i]->begin = count / num_threads * i + std::min(i, count % num_threads);
+		m_ranges[i]->end = m_ranges[i]->begin + count / num_threads + (i < count % num_threads);
+	}
+	if (num_threads == 1 || count <= 1) {
+		m_func = &func;
+		work(0);
+		m_func = nullptr;
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_func = &func;
+		++m_loop;
+		m_num_running = m_threads.size();
+	}
+	m_loop_started.notify_all();
+	work(0);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_loop_finished.wait(lock, [this]() { return m_num_running == 0; });
+	m_func = nullptr;
+}
+
+size_t ThreadPool::numThreads() const {
+	return m_ranges.size();
+}
+
+void ThreadPool::work(size_t thread) {
+	size_t i;
+	do {
+		while (takeOwn(thread, i)) {
+			(*m_func)(thread, i);
+		}
+	} while (steal(thread));
+}
+
+bool ThreadPool::takeOwn(size_t thread, size_t& i) {
+	Range& range = *m_ranges[thread];
+	std::lock_guard<std::mutex> lock(range.mutex);
+	if (range.begin == range.end) {
+		return false;
+	}
+	i = range.begin++;
+	return true;
+}
+
+bool ThreadPool::steal(size_t thread) {
+	for (;;) {
+		size_t victim = thread;
+		size_t largest = 0;
+		for (size_t i = 0; i < m_ranges.size(); ++i) {
+			std::lock_guard<std::mutex> lock(m_ranges[i]->mutex);
+			if (m_ranges[i]->end - m_ranges[i]->begin > largest) {
+				largest = m_ranges[i]->end - m_ranges[i]->begin;
+				victim = i;
+			}
+		}
+		if (largest == 0) {
+			return false;
+		}
+		size_t begin, end;
+		{
+			Range& range = *m_ranges[victim];
+			std::lock_guard<std::mutex> lock(range.mutex);
+			end = range.end;
+			begin = range.begin + (range.end - range.begin) / 2;
+			range.end = begin;
+		}
+		// The victim may have run out meanwhile, then look again
+		if (begin < end) {
+			Range& range = *m_ranges[thread];
+			std::lock_guard<std::mutex> lock(range.mutex);
+			range.begin = begin;
+			range.end = end;
+			return true;
+		}
+	}
+}
+
+void ThreadPool::threadMain(size_t thread) {
+	size_t loop = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_loop_started.wait(lock, [&]() { return m_stopping || m_loop != loop; });
+			if (m_stopping) {
+				return;
+			}
+			loop = m_loop;
+		}
+		work(thread);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_num_running == 0) {
+			m_loop_finished.notify_one();
+		}
+	}
+}
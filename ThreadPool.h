@@ -0,0 +1,74 @@
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of threads running parallel loops, balanced by work stealing.
+ * The indices of a loop are split into a contiguous range per thread. Each
+ * thread runs the indices of its own range from the front; a thread whose
+ * range is empty steals the back half of the largest remaining range. So
+ * loops whose iterations vary a lot in cost still keep all threads busy,
+ * while each thread mostly runs neighbouring indices.
+ */
+class ThreadPool final {
+public:
+	// Construct a pool of num_threads threads, including the calling thread
+	// of parallelFor (so num_threads-1 threads are started)
+	ThreadPool(size_t num_threads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Calls func(thread, i) for each i in [0, count), returning when all
+	// calls returned. thread is the index (below numThreads()) of the thread
+	// making the call, so func may use per-thread state without locking.
+	// func must not throw. Must not be called from func
+	void parallelFor(size_t count, const std::function<void(size_t thread, size_t i)>& func);
+
+	size_t numThreads() const;
+
+private:
+	// Indices [begin, end) of the current loop left to a thread
+	struct Range final {
+		std::mutex mutex;
+		size_t begin = 0;
+		size_t end = 0;
+	};
+
+	// Runs indices of the current loop on a thread until none are left
+	void work(size_t thread);
+
+	// Takes the next index of a thread's own range. False if it is empty
+	bool takeOwn(size_t thread, size_t& i);
+
+	// Moves the back half of the largest other range to a thread's own
+	// range. False if all are empty
+	bool steal(size_t thread);
+
+	// Loop of a started thread
+	void threadMain(size_t thread);
+
+	std::vector<std::unique_ptr<Range>> m_ranges;
+	std::vector<std::thread> m_threads;
+
+	// The current loop, its number (so threads run each loop once), and
+	// how many started threads are still running it
+	std::mutex m_mutex;
+	std::condition_variable m_loop_started;
+	std::condition_variable m_loop_finished;
+	const std::function<void(size_t, size_t)>* m_func;
+	size_t m_loop;
+	size_t m_num_running;
+	bool m_stopping;
+};
+
+#endif
@@ -0,0 +1,181 @@
+
+#include <algorithm>
+
+#include "Exceptions.h"
+#include "StringSort.h"
+#include "Trie.h"
+
+using std::string, std::string_view, std::vector;
+
+class Trie::Search final {
+public:
+	// rows is the buffer of the rows, reused across searches. Its size is
+	// the rows of depths up to max_depth, the deepest of the trie
+	Search(const vector<Node>& nodes, string_view word, size_t max_distance, size_t max_depth, vector<size_t>& rows)
+		: m_nodes(nodes)
+		, m_word(word)
+		, m_width(word.length() + 1)
+		, m_max_distance(max_distance)
+		, m_rows(rows) {
+		// A row past depth len + max_distance is all above max_distance
+		m_rows.resize((std::min(word.length() + max_distance, max_depth) + 1) * m_width);
+		for (size_t j = 0; j < m_width; ++j) {
+			m_rows[j] = j;
+		}
+	}
+
+	// Searches the subtrees of the children of node, at depth
+	void searchChildren(uint32_t node, size_t depth) {
+		if (!m_nodes[node].has_children) {
+			return;
+		}
+		for (uint32_t child = node + 1; child != NONE; child = m_nodes[child].next_sibling) {
+			searchNode(child, depth + 1);
+		}
+	}
+
+	vector<Match>& matches() {
+		return m_matches;
+	}
+
+private:
+	// Computes the row of node at depth, from the rows of its ancestors
+	void searchNode(uint32_t node, size_t depth) {
+		// Only the band of columns within max_distance of the diagonal can
+		// be within max_distance. Entries out of it are taken as
+		// max_distance + 1, as are all entries above it
+		size_t over = m_max_distance + 1;
+		size_t lo = depth > m_max_distance ? depth - m_max_distance : 1;
+		size_t hi = std::min(depth + m_max_distance, m_width - 1);
+		if (lo > hi) {
+			return;
+		}
+		char letter = m_nodes[node].letter;
+		const size_t* prev2 = depth > 1 ? &m_rows[(depth-2) * m_width] : nullptr;
+		const size_t* prev = &m_rows[(depth-1) * m_width];
+		size_t* cur = &m_rows[depth * m_width];
+		cur[0] = depth;
+		if (lo > 1) {
+			cur[lo-1] = over;
+		}
+		size_t row_min = lo == 1 ? depth : over;
+		for (size_t j = lo; j <= hi; ++j) {
+			size_t cost = m_word[j-1] == letter ? 0 : 1;
+			cur[j] = std::min({prev[j] + 1, cur[j-1] + 1, prev[j-1] + cost, over});
+			if (prev2 && j > 1 && m_word[j-1] == m_path.back() && m_word[j-2] == letter) {
+				cur[j] = std::min(cur[j], prev2[j-2] + 1);
+			}
+			row_min = std::min(row_min, cur[j]);
+		}
+		if (hi + 1 < m_width) {
+			cur[hi+1] = over;
+		}
+		if (row_min > m_max_distance) {
+			// Rows only grow deeper, even with transpositions: a
+			// transposition costs no less than the substitution it skips
+			return;
+		}
+		size_t distance = hi == m_width - 1 ? cur[hi] : over;
+		m_path.push_back(letter);
+		if (m_nodes[node].is_word && distance <= m_max_distance) {
+			m_matches.push_back(Match{m_path, distance});
+		}
+		searchChildren(node, depth);
+		m_path.pop_back();
+	}
+
+	const vector<Node>& m_nodes;
+	string_view m_word;
+	size_t m_width;
+	size_t m_max_distance;
+
+	// Row of each depth of the current path, m_width entries each
+	vector<size_t>& m_rows;
+
+	// Letters of the current path
+	string m_path;
+
+	vector<Match> m_matches;
+};
+
+Trie::Trie(const Dictionary& dict, size_t max_distance)
+	: m_max_distance(max_distance)
+	, m_max_depth(0) {
+	if (max_distance < 1 || max_distance > MAX_DISTANCE) {
+		throw InvalidOption("Trie distance must be between 1 and " + std::to_string(MAX_DISTANCE));
+	}
+	vector<string> words;
+	words.reserve(dict.size());
+	dict.forEachWord([&](const string& word) {
+		words.push_back(word);
+	});
+	multikeySort(words);
+
+	m_nodes.push_back(Node{NONE, '\0', false, false});
+	// Nodes on the path of the previous word, by depth
+	vector<uint32_t> path{0};
+	string_view prev_word;
+	for (const auto& word : words) {
+		if (word.empty()) {
+			continue;
+		}
+		size_t common = std::mismatch(prev_word.begin(), prev_word.end(), word.begin(), word.end()).first - prev_word.begin();
+		// Words are sorted, so a new node is always the last child of its
+		// parent. The first new node follows the node of the previous word
+		// at its depth, if any, and the others are first children
+		uint32_t prev_sibling = common + 1 < path.size() ? path[common+1] : NONE;
+		path.resize(common + 1);
+		for (size_t depth = common + 1; depth <= word.length(); ++depth) {
+			if (m_nodes.size() >= NONE) {
+				throw InvalidOption("Dictionary is too large for a trie");
+			}
+			uint32_t node = m_nodes.size();
+			if (prev_sibling != NONE) {
+				m_nodes[prev_sibling].next_sibling = node;
+				prev_sibling = NONE;
+			}
+			else {
+				// A first child is always created right after its parent
+				m_nodes[path.back()].has_children = true;
+			}
+			m_nodes.push_back(Node{NONE, word[depth-1], false, false});
+			path.push_back(node);
+		}
+		m_nodes[path.back()].is_word = true;
+		m_max_depth = std::max(m_max_depth, word.length());
+		prev_word = word;
+	}
+	m_nodes.shrink_to_fit();
+}
+
+Trie::~Trie() {}
+
+vector<Trie::Match> Trie::find(string_view word, size_t max_distance) const {
+	max_distance = std::min(max_distance, m_max_distance);
+	if (word.length() > m_max_depth + max_distance) {
+		// Longer than any word by more than the distance
+		return {};
+	}
+	// Reused across the searches of a thread, so a search only allocates
+	// for a word longer than those before
+	static thread_local vector<size_t> rows;
+	Search search(m_nodes, word, max_distance, m_max_depth, rows);
+	search.searchChildren(0, 0);
+	// Found in lexicographic order, keep it among equally distant words
+	std::stable_sort(search.matches().begin(), search.matches().end(), [](const Match& a, const Match& b) {
+		return a.distance < b.distance;
+	});
+	return std::move(search.matches());
+}
+
+size_t Trie::maxDistance() const {
+	return m_max_distance;
+}
+
+size_t Trie::numNodes() const {
+	return m_nodes.size();
+}
+
+size_t Trie::sizeBytes() const {
+	return m_nodes.capacity() * sizeof(Node);
+}
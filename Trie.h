@@ -0,0 +1,72 @@
+
+#ifndef TRIE_H
+#define TRIE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Dictionary.h"
+#include "Suggester.h"
+
+/**
+ * The words of a dictionary in a trie, searched for all words within a
+ * distance of a queried word by walking the trie depth first while computing
+ * one row of the edit distance matrix per node (the row of the prefix the
+ * node spells, against the queried word). A row shared by all the words of a
+ * subtree is computed once, and a subtree is pruned as soon as the minimum of
+ * its row exceeds the distance - no word in it can come back within reach.
+ * Unlike DeletionIndex, nothing is built per distance, but a search visits
+ * many more nodes as the distance grows, so it is capped lower.
+ * Nodes are kept in one array in depth first (lexicographic) order. The
+ * first child of a node is always the next node, and siblings are linked.
+ */
+class Trie final : public Suggester {
+public:
+	// Largest supported distance
+	static constexpr size_t MAX_DISTANCE = 3;
+
+	// Builds a trie of the words of dict, for queries of distance up to
+	// max_distance. Throws InvalidOption if max_distance is not supported
+	Trie(const Dictionary& dict, size_t max_distance);
+	~Trie();
+
+	std::vector<Match> find(std::string_view word, size_t max_distance) const override;
+
+	size_t maxDistance() const override;
+
+	// Number of nodes in the trie
+	size_t numNodes() const;
+
+	// Memory used by the trie in bytes
+	size_t sizeBytes() const;
+
+private:
+	// No next sibling
+	static constexpr uint32_t NONE = UINT32_MAX;
+
+	struct Node final {
+		// Index of the next sibling, or NONE
+		uint32_t next_sibling;
+		// Letter on the edge from the parent
+		char letter;
+		// Whether the path to this node spells a word
+		bool is_word;
+		// Whether the node has children (starting at the next node)
+		bool has_children;
+	};
+
+	// State of a single find()
+	class Search;
+
+	size_t m_max_distance;
+
+	// Length of the longest word
+	size_t m_max_depth;
+
+	// m_nodes[0] is the root
+	std::vector<Node> m_nodes;
+};
+
+#endif
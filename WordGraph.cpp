@@ -0,0 +1,343 @@
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <utility>
+
+#include "Exceptions.h"
+#include "WordGraph.h"
+#include "hash.h"
+
+using std::string, std::string_view, std::vector;
+
+constexpr char GRAPH_MAGIC[8] = {'S', 'P', 'L', 'C', 'H', 'D', 'W', 'G'};
+
+// Bump whenever the layout of the graph file changes
+constexpr uint32_t GRAPH_VERSION = 2;
+
+// Layout of an edge
+constexpr uint32_t LETTER_MASK = 0xff;
+constexpr uint32_t LAST_EDGE = 1 << 8;
+constexpr uint32_t ENDS_WORD = 1 << 9;
+constexpr int TARGET_SHIFT = 10;
+constexpr size_t MAX_EDGES = size_t(1) << (32 - TARGET_SHIFT);
+
+struct WordGraph::Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t root; // index of the first edge of the root state
+	uint64_t num_words_in_file;
+	uint64_t num_words;
+	uint64_t num_edges; // including the unused edge 0, padded to an even number
+	uint64_t checksum; // of the fields above and everything following the header
+};
+
+uint64_t WordGraph::checksumOf(const Header& header, const char* body, size_t body_size) {
+	static_assert(offsetof(Header, checksum) % 8 == 0, "fileChecksum consumes 8 bytes at a time");
+	uint64_t header_checksum = fileChecksum(reinterpret_cast<const char*>(&header), offsetof(Header, checksum));
+	return fileChecksum(body, body_size, header_checksum);
+}
+
+// Whether every state reachable from root, and every target of its edges,
+// starts a run of edges ending within the graph, and no word loops back to
+// a state on its own path
+static bool isWellFormed(const uint32_t* edges, size_t num_edges, uint32_t root) {
+	// Any run starting at or before the last edge ending a state ends there
+	size_t last_end = 0;
+	for (size_t i = 1; i < num_edges; ++i) {
+		if (edges[i] & LAST_EDGE) {
+			last_end = i;
+		}
+	}
+	if (root == 0) {
+		return true;
+	}
+	if (root > last_end) {
+		return false;
+	}
+	for (size_t i = 1; i < num_edges; ++i) {
+		if ((edges[i] >> TARGET_SHIFT) > last_end) {
+			return false;
+		}
+	}
+	// Depth first search for a cycle: states on the path, then states done
+	enum : uint8_t { UNSEEN, ON_PATH, DONE };
+	vector<uint8_t> seen(num_edges, UNSEEN);
+	// A state on the path and the next of its edges to follow, 0 when all
+	// were followed
+	vector<std::pair<uint32_t, uint32_t>> path{{root, root}};
+	seen[root] = ON_PATH;
+	while (!path.empty()) {
+		auto& [state, edge] = path.back();
+		if (edge == 0) {
+			seen[state] = DONE;
+			path.pop_back();
+			continue;
+		}
+		uint32_t target = edges[edge] >> TARGET_SHIFT;
+		edge = (edges[edge] & LAST_EDGE) ? 0 : edge + 1;
+		if (target != 0 && seen[target] == ON_PATH) {
+			return false;
+		}
+		if (target != 0 && seen[target] == UNSEEN) {
+			seen[target] = ON_PATH;
+			path.emplace_back(target, target);
+		}
+	}
+	return true;
+}
+
+WordGraph::WordGraph(const Dictionary& dict, size_t num_words_in_file)
+	: m_num_words_in_file(num_words_in_file) {
+	vector<string> words;
+	words.reserve(dict.size());
+	dict.forEachWord([&](const string& word) {
+		if (!word.empty()) {
+			words.push_back(word);
+		}
+	});
+	std::sort(words.begin(), words.end());
+	words.erase(std::unique(words.begin(), words.end()), words.end());
+	m_num_words = words.size();
+	build(words);
+	m_edges = m_built.data();
+	m_num_edges = m_built.size();
+}
+
+WordGraph::WordGraph(string path)
+	: m_file(std::make_unique<MappedFile>(path)) {
+	if (m_file->size() < sizeof(Header)) {
+		throw InvalidIndex("'" + path + "' is too short to be a word graph");
+	}
+	const Header* header = reinterpret_cast<const Header*>(m_file->data());
+	if (memcmp(header->magic, GRAPH_MAGIC, sizeof(GRAPH_MAGIC)) != 0) {
+		throw InvalidIndex("'" + path + "' is not a word graph");
+	}
+	if (header->version != GRAPH_VERSION) {
+		throw InvalidIndex("'" + path + "' was built by an incompatible version, rebuild it");
+	}
+	// The size is compared by number of edges, so a corrupted header cannot
+	// overflow it
+	size_t body_size = m_file->size() - sizeof(Header);
+	if (header->num_edges % 2 != 0 || body_size % sizeof(uint32_t) != 0
+		|| header->num_edges != body_size / sizeof(uint32_t)) {
+		throw InvalidIndex("'" + path + "' is truncated");
+	}
+	const char* body = m_file->data() + sizeof(Header);
+	if (checksumOf(*header, body, body_size) != header->checksum) {
+		throw InvalidIndex("'" + path + "' is corrupted (checksum mismatch)");
+	}
+	// A checksum only catches accidents, so the edges are also checked to
+	// stay within the graph
+	if (header->num_edges == 0 || !isWellFormed(reinterpret_cast<const uint32_t*>(body), header->num_edges, header->root)) {
+		throw InvalidIndex("'" + path + "' is corrupted (edges out of bounds)");
+	}
+	m_edges = reinterpret_cast<const uint32_t*>(body);
+	m_num_edges = header->num_edges;
+	m_root = header->root;
+	m_num_words = header->num_words;
+	m_num_words_in_file = header->num_words_in_file;
+}
+
+WordGraph::~WordGraph() {}
+
+void WordGraph::build(const vector<string>& words) {
+	// A state while building. Its edges are to registered states, except
+	// for the last edge of a state on the path of the last word added
+	struct State final {
+		vector<std::pair<char, uint32_t>> edges;
+		bool is_word = false;
+	};
+	vector<State> states(1);
+	vector<uint32_t> free_states;
+	auto newState = [&]() {
+		if (free_states.empty()) {
+			states.emplace_back();
+			return static_cast<uint32_t>(states.size() - 1);
+		}
+		uint32_t state = free_states.back();
+		free_states.pop_back();
+		states[state] = State();
+		return state;
+	};
+
+	// Registered states, by their word flag and edges. Two states with the
+	// same key have the same subtree, as their targets are registered
+	std::unordered_map<string, uint32_t> registered;
+	auto keyOf = [](const State& state) {
+		string key(1, state.is_word);
+		for (const auto& [letter, target] : state.edges) {
+			key += letter;
+			key.append(reinterpret_cast<const char*>(&target), sizeof(target));
+		}
+		return key;
+	};
+
+	// States on the path of the last word added, path[0] is the root
+	vector<uint32_t> path{0};
+	// Registers the states of path deeper than depth, replacing each by an
+	// equal registered state if any
+	auto registerPath = [&](size_t depth) {
+		for (size_t i = path.size() - 1; i > depth; --i) {
+			auto [found, inserted] = registered.emplace(keyOf(states[path[i]]), path[i]);
+			if (!inserted) {
+				states[path[i-1]].edges.back().second = found->second;
+				free_states.push_back(path[i]);
+			}
+		}
+		path.resize(depth + 1);
+	};
+	string_view prev;
+	for (const string& word : words) {
+		size_t common = 0;
+		while (common < prev.length() && common < word.length() && prev[common] == word[common]) {
+			++common;
+		}
+		registerPath(common);
+		for (size_t i = common; i < word.length(); ++i) {
+			uint32_t state = newState();
+			states[path.back()].edges.emplace_back(word[i], state);
+			path.push_back(state);
+		}
+		states[path.back()].is_word = true;
+		prev = word;
+	}
+	registerPath(0);
+
+	// Lay out the edges of each state reachable from the root, depth first
+	vector<uint32_t> first_edge(states.size(), 0);
+	vector<uint32_t> order;
+	vector<uint32_t> stack{0};
+	size_t num_edges = 1;
+	while (!stack.empty()) {
+		uint32_t state = stack.back();
+		stack.pop_back();
+		if (states[state].edges.empty() || first_edge[state] != 0) {
+			continue;
+		}
+		if (num_edges + states[state].edges.size() > MAX_EDGES) {
+			throw InvalidIndex("Dictionary is too large for a word graph");
+		}
+		first_edge[state] = static_cast<uint32_t>(num_edges);
+		num_edges += states[state].edges.size();
+		order.push_back(state);
+		for (auto it = states[state].edges.rbegin(); it != states[state].edges.rend(); ++it) {
+			stack.push_back(it->second);
+		}
+	}
+	m_built.assign(1, 0);
+	m_built.reserve(num_edges + 1);
+	for (uint32_t state : order) {
+		const auto& edges = states[state].edges;
+		for (size_t i = 0; i < edges.size(); ++i) {
+			uint32_t target = edges[i].second;
+			m_built.push_back(static_cast<unsigned char>(edges[i].first)
+				| (i + 1 == edges.size() ? LAST_EDGE : 0)
+				| (states[target].is_word ? ENDS_WORD : 0)
+				| first_edge[target] << TARGET_SHIFT);
+		}
+	}
+	if (m_built.size() % 2 != 0) {
+		m_built.push_back(0);
+	}
+	m_root = first_edge[0];
+}
+
+void WordGraph::write(string path) const {
+	Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, GRAPH_MAGIC, sizeof(GRAPH_MAGIC));
+	header.version = GRAPH_VERSION;
+	header.root = m_root;
+	header.num_words_in_file = m_num_words_in_file;
+	header.num_words = m_num_words;
+	header.num_edges = m_num_edges;
+	header.checksum = checksumOf(header, reinterpret_cast<const char*>(m_edges), m_num_edges * sizeof(uint32_t));
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(m_edges), m_num_edges * sizeof(uint32_t));
+	if (!out) {
+		throw FileError("Cannot write word graph to '" + path + "'");
+	}
+}
+
+bool WordGraph::isGraph(string path) {
+	// Graphs are mapped, so must be regular files. Reading the start of
+	// anything else (e.g. a pipe) would consume it
+	std::error_code err;
+	if (!std::filesystem::is_regular_file(path, err)) {
+		return false;
+	}
+	std::ifstream in(path, std::ios::binary);
+	char magic[sizeof(GRAPH_MAGIC)];
+	if (!in.read(magic, sizeof(magic))) {
+		return false;
+	}
+	return memcmp(magic, GRAPH_MAGIC, sizeof(GRAPH_MAGIC)) == 0;
+}
+
+size_t WordGraph::numWordsInFile() const {
+	return m_num_words_in_file;
+}
+
+size_t WordGraph::numEdges() const {
+	return m_num_edges;
+}
+
+size_t WordGraph::sizeBytes() const {
+	return m_num_edges * sizeof(uint32_t);
+}
+
+bool WordGraph::lookup(string_view word) const {
+	uint32_t state = m_root;
+	for (size_t i = 0; i < word.length(); ++i) {
+		if (state == 0) {
+			return false;
+		}
+		uint32_t letter = static_cast<unsigned char>(word[i]);
+		uint32_t edge = m_edges[state];
+		// Edges are sorted by letter, so stop at the first past it
+		while ((edge & LETTER_MASK) != letter) {
+			if ((edge & LETTER_MASK) > letter || (edge & LAST_EDGE)) {
+				return false;
+			}
+			edge = m_edges[++state];
+		}
+		if (i + 1 == word.length()) {
+			return edge & ENDS_WORD;
+		}
+		state = edge >> TARGET_SHIFT;
+	}
+	return false;
+}
+
+size_t WordGraph::size() const {
+	return m_num_words;
+}
+
+void WordGraph::forEachWord(word_func_t func) const {
+	string word;
+	forEachWord(m_root, word, func);
+}
+
+void WordGraph::forEachWord(uint32_t state, string& word, const word_func_t& func) const {
+	if (state == 0) {
+		return;
+	}
+	for (size_t idx = state;; ++idx) {
+		uint32_t edge = m_edges[idx];
+		word.push_back(static_cast<char>(edge & LETTER_MASK));
+		if (edge & ENDS_WORD) {
+			func(word);
+		}
+		forEachWord(edge >> TARGET_SHIFT, word, func);
+		word.pop_back();
+		if (edge & LAST_EDGE) {
+			return;
+		}
+	}
+}
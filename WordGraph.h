@@ -0,0 +1,84 @@
+
+#ifndef WORDGRAPH_H
+#define WORDGRAPH_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Dictionary.h"
+#include "MappedFile.h"
+
+/**
+ * The words of a dictionary in a minimal acyclic word graph (DAWG): a trie
+ * whose identical subtrees are merged, so words share their suffixes as well
+ * as their prefixes. Built from the sorted words in one pass, merging each
+ * subtree as soon as no more words can be added to it (Daciuk et al.).
+ * A state is stored as the run of its outgoing edges, sorted by letter. An
+ * edge is packed in 32 bits: its letter, whether it is the last edge of its
+ * state, whether it ends a word, and the index of the first edge of its
+ * target state (0 if the target has no edges).
+ * The edges are written to a file as is, after a header like that of
+ * DictionaryIndex, so a written graph is mapped and queried in place.
+ */
+class WordGraph final : public Dictionary {
+public:
+	// Builds the graph of the words of dict. num_words_in_file is the number
+	// of words (with repetitions) the dictionary was built from, kept for
+	// reporting
+	WordGraph(const Dictionary& dict, size_t num_words_in_file);
+
+	// Maps a graph file written by write(). Throws InvalidIndex if it is
+	// stale or corrupted
+	WordGraph(std::string path);
+
+	~WordGraph();
+
+	// Writes the graph into a file at path
+	void write(std::string path) const;
+
+	// Check whether the file at path is a regular file starting like a graph
+	// file
+	static bool isGraph(std::string path);
+
+	// Number of words (with repetitions) the graph was built from
+	size_t numWordsInFile() const;
+
+	// Number of edges in the graph
+	size_t numEdges() const;
+
+	// Memory used by the edges in bytes
+	size_t sizeBytes() const;
+
+	bool lookup(std::string_view word) const override;
+	size_t size() const override;
+	void forEachWord(word_func_t func) const override;
+
+private:
+	// Layout of the file header
+	struct Header;
+
+	// Checksum of the header fields before the checksum, and of the edges
+	static uint64_t checksumOf(const Header& header, const char* body, size_t body_size);
+
+	// Builds the edges of the graph of sorted unique words into m_built
+	void build(const std::vector<std::string>& words);
+
+	// Calls func with word + every word the edges starting at state spell
+	void forEachWord(uint32_t state, std::string& word, const word_func_t& func) const;
+
+	// Edges of a graph built in memory, or the graph file they are mapped from
+	std::vector<uint32_t> m_built;
+	std::unique_ptr<MappedFile> m_file;
+
+	// m_edges[0] is unused, as 0 is the state without edges
+	const uint32_t* m_edges;
+	size_t m_num_edges;
+	uint32_t m_root;
+	size_t m_num_words;
+	size_t m_num_words_in_file;
+};
+
+#endif
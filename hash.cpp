@@ -1,13 +1,16 @@
 
+#include <cstring>
+
+#include "Exceptions.h"
 #include "hash.h"
 
-using std::string;
+using std::string, std::string_view, std::vector;
 
 // Some prime number larger than a word and smaller then a dword
 constexpr size_t MULTIPLIER = 1000003;
 constexpr size_t SALT = 0x99999999;
 
-size_t hash(std::string str) {
+size_t hash(string_view str) {
 	// No great theory behind this, there is not much discussion about hashing
 	// strings in the book - the algorithms which are discussed assume we can
 	// encode it as a giant number which will require the use of a bignum
@@ -27,3 +30,182 @@ size_t hash(std::string str) {
 	}
 	return accumulator;
 }
+
+// wyhash is written by Wang Yi and released to the public domain
+// https://github.com/wangyi-fudan/wyhash
+constexpr uint64_t WY_SECRET[4] = {
+	0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+	0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+// 128 bit product of a and b, low half into a and high half into b
+static inline void wyMum(uint64_t& a, uint64_t& b) {
+	__uint128_t r = static_cast<__uint128_t>(a) * b;
+	a = static_cast<uint64_t>(r);
+	b = static_cast<uint64_t>(r >> 64);
+}
+
+static inline uint64_t wyMix(uint64_t a, uint64_t b) {
+	wyMum(a, b);
+	return a ^ b;
+}
+
+static inline uint64_t read8(const char* p) {
+	uint64_t v;
+	memcpy(&v, p, 8);
+	return v;
+}
+
+static inline uint64_t read4(const char* p) {
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+size_t wyhash(string_view str) {
+	return wyhashSeeded(str, 0);
+}
+
+uint64_t wyhashSeeded(string_view str, uint64_t seed) {
+	const char* p = str.data();
+	size_t len = str.length();
+	seed ^= wyMix(seed ^ WY_SECRET[0], WY_SECRET[1]);
+	uint64_t a, b;
+	if (len <= 16) {
+		if (len >= 4) {
+			size_t mid = (len >> 3) << 2;
+			a = (read4(p) << 32) | read4(p + mid);
+			b = (read4(p + len - 4) << 32) | read4(p + len - 4 - mid);
+		}
+		else if (len > 0) {
+			a = (static_cast<uint64_t>(static_cast<uint8_t>(p[0])) << 16)
+				| (static_cast<uint64_t>(static_cast<uint8_t>(p[len >> 1])) << 8)
+				| static_cast<uint8_t>(p[len - 1]);
+			b = 0;
+		}
+		else {
+			a = b = 0;
+		}
+	}
+	else {
+		size_t i = len;
+		if (i >= 48) {
+			uint64_t seed1 = seed, seed2 = seed;
+			do {
+				seed = wyMix(read8(p) ^ WY_SECRET[1], read8(p + 8) ^ seed);
+				seed1 = wyMix(read8(p + 16) ^ WY_SECRET[2], read8(p + 24) ^ seed1);
+				seed2 = wyMix(read8(p + 32) ^ WY_SECRET[3], read8(p + 40) ^ seed2);
+				p += 48;
+				i -= 48;
+			} while (i >= 48);
+			seed ^= seed1 ^ seed2;
+		}
+		while (i > 16) {
+			seed = wyMix(read8(p) ^ WY_SECRET[1], read8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = read8(p + i - 16);
+		b = read8(p + i - 8);
+	}
+	a ^= WY_SECRET[1];
+	b ^= seed;
+	wyMum(a, b);
+	return wyMix(a ^ WY_SECRET[0] ^ len, b ^ WY_SECRET[1]);
+}
+
+#if __x86_64__
+#include <nmmintrin.h>
+
+__attribute__((target("sse4.2")))
+size_t crc32Hash(string_view str) {
+	// Two independent CRC lanes with different seeds make up 64 bits, and
+	// run in parallel on the CPU
+	const char* p = str.data();
+	size_t len = str.length();
+	uint64_t lo = 0x9E3779B9, hi = 0x7F4A7C15 ^ len;
+	for (; len >= 8; len -= 8, p += 8) {
+		lo = _mm_crc32_u64(lo, read8(p));
+		hi = _mm_crc32_u64(hi, read8(p) ^ WY_SECRET[0]);
+	}
+	if (len > 0) {
+		// Read the tail without a variable sized copy, overlapping bytes that
+		// were already consumed (or read twice) when possible
+		uint64_t tail;
+		if (str.length() >= 8) {
+			tail = read8(p + len - 8) >> (64 - 8*len);
+		}
+		else if (len >= 4) {
+			tail = read4(p) | (read4(p + len - 4) << 32);
+		}
+		else {
+			tail = static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[len >> 1]) << 8)
+				| (static_cast<uint8_t>(p[len - 1]) << 16);
+		}
+		lo = _mm_crc32_u64(lo, tail);
+		hi = _mm_crc32_u64(hi, tail ^ WY_SECRET[0]);
+	}
+	// CRC is linear; a multiplication spreads its bits over the whole hash
+	uint64_t res = ((hi << 32) | lo) * 0x9E3779B97F4A7C15ull;
+	return res ^ (res >> 32);
+}
+
+bool crc32HashAvailable() {
+	// May run before the CPU features are detected by the runtime
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.2");
+}
+#else
+size_t crc32Hash(string_view str) {
+	return wyhash(str);
+}
+
+bool crc32HashAvailable() {
+	return false;
+}
+#endif
+
+static vector<Hasher> listHashers() {
+	vector<Hasher> res = {
+		{1, "multiplicative", hash},
+		{2, "wyhash", wyhash}
+	};
+	if (crc32HashAvailable()) {
+		res.push_back({3, "crc32", crc32Hash});
+	}
+	return res;
+}
+
+const vector<Hasher>& availableHashers() {
+	static const vector<Hasher> hashers = listHashers();
+	return hashers;
+}
+
+const Hasher& findHasher(string name) {
+	for (const auto& hasher : availableHashers()) {
+		if (name == hasher.name) {
+			return hasher;
+		}
+	}
+	throw InvalidOption("Unknown hash function '" + name + "'");
+}
+
+const Hasher* findHasher(uint32_t id) {
+	for (const auto& hasher : availableHashers()) {
+		if (id == hasher.id) {
+			return &hasher;
+		}
+	}
+	return nullptr;
+}
+
+uint64_t fileChecksum(const char* data, size_t len, uint64_t seed) {
+	uint64_t accumulator = seed;
+	for (size_t i = 0; i < len; i += 8) {
+		uint64_t word;
+		memcpy(&word, data + i, 8);
+		accumulator = (accumulator ^ word) * 0x100000001b3;
+		accumulator ^= accumulator >> 29;
+	}
+	return accumulator;
+}
@@ -2,8 +2,57 @@
 #ifndef HASH_H
 #define HASH_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
-size_t hash(std::string str);
+// Signature shared by all string hash functions
+using string_hash_t = size_t(*)(std::string_view);
+
+// Byte-at-a-time multiplicative hash, the original hash of this program
+size_t hash(std::string_view str);
+
+// wyhash (final version 4), consuming the string 8 bytes at a time
+size_t wyhash(std::string_view str);
+
+// wyhash with a seed, as in the reference implementation and its test
+// vectors. wyhash is seed 0
+uint64_t wyhashSeeded(std::string_view str, uint64_t seed);
+
+// Hash built on the CRC32 instruction of SSE4.2. Only call this if
+// crc32HashAvailable() returns true
+size_t crc32Hash(std::string_view str);
+
+// True iff the CPU running the program supports crc32Hash
+bool crc32HashAvailable();
+
+// A string hash function, selectable by name
+struct Hasher final {
+	// Stable id, recorded in index files
+	uint32_t id;
+	const char* name;
+	string_hash_t func;
+};
+
+// Name of the hash function used when none is chosen
+constexpr const char* DEFAULT_HASHER = "wyhash";
+
+// All hash functions usable on the running CPU
+const std::vector<Hasher>& availableHashers();
+
+// Find an available hash function by name. Throws InvalidOption if none
+const Hasher& findHasher(std::string name);
+
+// Find an available hash function by id. Returns nullptr if none
+const Hasher* findHasher(uint32_t id);
+
+// Initial state of fileChecksum
+constexpr uint64_t FILE_CHECKSUM_SEED = 0xcbf29ce484222325;
+
+// FNV style checksum of index files, consuming 8 bytes at a time. len must be
+// a multiple of 8. Passing the checksum of the data before as seed continues
+// it, so a header and a body are checksummed as if contiguous
+uint64_t fileChecksum(const char* data, size_t len, uint64_t seed = FILE_CHECKSUM_SEED);
 
 #endif
@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+
+#include "hash.h"
+
+using std::cout, std::endl;
+
+// A string, the seed it is hashed with and its expected hash
+struct KnownAnswer final {
+	std::string_view str;
+	uint64_t seed;
+	uint64_t hash;
+};
+
+// The test vectors published with the reference wyhash final version 4,
+// followed by strings of 47, 48, 49 and 96 bytes around the 48 byte blocks
+// of the bulk loop, hashed by the reference algorithm
+constexpr KnownAnswer WYHASH_ANSWERS[] = {
+	{"", 0, 0x93228a4de0eec5a2ull},
+	{"a", 1, 0xc5bac3db178713c4ull},
+	{"abc", 2, 0xa97f2f7b1d9b3314ull},
+	{"message digest", 3, 0x786d1f1df3801df4ull},
+	{"abcdefghijklmnopqrstuvwxyz", 4, 0xdca5a8138ad37c87ull},
+	{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", 5, 0xb9e734f117cfaf70ull},
+	{"12345678901234567890123456789012345678901234567890123456789012345678901234567890", 6,
+		0x6cc5eab49a92d617ull},
+	{"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJK", 0, 0x760c21c330ce8d37ull},
+	{"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKL", 0, 0xdcc815460c05b043ull},
+	{"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKL0", 0, 0x5b314ccb3262acc1ull},
+	{"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKL0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKL", 0,
+		0x1b522b69d59bd4a7ull},
+};
+
+// Checks the hash functions against known answers, failing on any mismatch
+int main() {
+	int failures = 0;
+	for (const auto& answer : WYHASH_ANSWERS) {
+		uint64_t hash = wyhashSeeded(answer.str, answer.seed);
+		if (hash != answer.hash) {
+			cout << "wyhash of " << answer.str.length() << " bytes with seed " << answer.seed << ": got 0x"
+				<< std::hex << hash << ", expected 0x" << answer.hash << std::dec << endl;
+			++failures;
+		}
+		if (answer.seed == 0 && wyhash(answer.str) != answer.hash) {
+			cout << "wyhash of " << answer.str.length() << " bytes differs from seed 0" << endl;
+			++failures;
+		}
+	}
+	cout << (failures ? "FAILED" : "All hash tests passed") << endl;
+	return failures ? 1 : 0;
+}
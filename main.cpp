@@ -1,22 +1,210 @@
-
+#include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "App.h"
+#include "Client.h"
+#include "Config.h"
+#include "DeletionIndex.h"
+#include "Trie.h"
+
 
+using std::cout, std::cerr, std::endl, std::string;
 
-using std::cout, std::endl, std::string;
 
+static void usage() {
+    cout << "Usage: ./spellchecker [options] <dict> [files...]" << endl;
+    cout << "       ./spellchecker [options] --build-index <dict> <index>" << endl;
+    cout << "       ./spellchecker [options] --serve <socket> <dict>" << endl;
+    cout << "       ./spellchecker --client <socket> check|suggest [words...]" << endl;
+    cout << "Options:" << endl;
+    cout << "    --hash <name>    string hash function:";
+    for (const auto& hasher : availableHashers()) {
+        cout << " " << hasher.name;
+    }
+    cout << " (default " << DEFAULT_HASHER << ")" << endl;
+    cout << "    --dawg               keep the dictionary in a word graph, using less memory" << endl;
+    cout << "                         (with --build-index, write a word graph file)" << endl;
+    cout << "    --by-length          keep the dictionary in a compact table per word length" << endl;
+    cout << "    --bloom <rate>       front the dictionary by a Bloom filter with this" << endl;
+    cout << "                         false positive rate (e.g. 0.01)" << endl;
+    cout << "    --symspell <k>       fall back to suggestions within distance k from a" << endl;
+    cout << "                         deletion index of the dictionary (k up to " << DeletionIndex::MAX_DISTANCE << ")" << endl;
+    cout << "    --symspell-memory <MB>  memory cap of the deletion index (default "
+        << Config().deletion_memory_mb << ")" << endl;
+    cout << "    --trie <k>           fall back to suggestions within distance k from a" << endl;
+    cout << "                         search of a trie of the dictionary (k up to " << Trie::MAX_DISTANCE << ")" << endl;
+    cout << "    --cache <n>          cache up to n suggestions across checked files" << endl;
+    cout << "    --cache-file <path>  load the suggestion cache from, and save it to, a file" << endl;
+    cout << "    --top <k>            show up to k suggestions per word, most frequent first" << endl;
+    cout << "    --frequencies <path> rank suggestions by a file of '<word> <count>' lines" << endl;
+    cout << "    --max-probes <n>     look up at most n candidates when ranking a word's suggestions" << endl;
+    cout << "    --max-us <n>         spend at most n microseconds ranking a word's suggestions" << endl;
+    cout << "    -t, --threads <n>    number of threads (default: number of cores)" << endl;
+    cout << "    -j, --jobs <n>       check n files at a time (default 1)" << endl;
+    cout << "    --stream             check standard input (or the files) as it is read," << endl;
+    cout << "                         reporting misspelled words as soon as they are seen" << endl;
+    cout << "    --seen-cap <n>       words remembered as seen while streaming (default "
+        << Config().stream_seen_cap << ")" << endl;
+    cout << "    --serve <socket>     load the dictionary once and serve requests on a Unix socket" << endl;
+    cout << "    --max-clients <n>    requests answered at a time (default "
+        << Config().max_clients << ")" << endl;
+    cout << "    --client <socket>    send a request (or one per line of standard input) to a server" << endl;
+    cout << "    --format <name>      report format: text (default), or jsonl for a JSON object" << endl;
+    cout << "                         per misspelled word, with progress written to stderr" << endl;
+    cout << "    --tree               collect checked words in a red-black tree (original pipeline)" << endl;
+}
+
+// Value of the option at argv[i], advancing i past it
+static string optionValue(int argc, char** argv, int& i) {
+    if (i + 1 >= argc) {
+        throw InvalidOption(string("Missing value for ") + argv[i]);
+    }
+    return argv[++i];
+}
+
+// Positive number value of the option at argv[i], advancing i past it
+static size_t countValue(int argc, char** argv, int& i) {
+    string option = argv[i];
+    string value = optionValue(argc, argv, i);
+    if (value.empty() || value.find_first_not_of("0123456789") != string::npos || std::stoul(value) == 0) {
+        throw InvalidOption("Expected a positive number for " + option);
+    }
+    return std::stoul(value);
+}
+
+// Sets the fallback suggestion engine and its distance from the option at
+// argv[i], advancing i past it
+static void fallbackValue(int argc, char** argv, int& i, string engine, Config& config) {
+    if (!config.fallback_engine.empty()) {
+        throw InvalidOption("Only one of --symspell and --trie may be given");
+    }
+    config.fallback_engine = engine;
+    config.fallback_distance = countValue(argc, argv, i);
+}
 
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        cout << "Usage: ./spellchecker <dict> [files...]" << endl;
-        return 1;
+    try {
+        Config config;
+        bool build_index = false;
+        string client_path;
+        int i = 1;
+        for (; i < argc && argv[i][0] == '-'; ++i) {
+            string option = argv[i];
+            if (option == "--build-index") {
+                build_index = true;
+            }
+            else if (option == "--hash") {
+                config.hash_name = optionValue(argc, argv, i);
+            }
+            else if (option == "--dawg") {
+                config.use_word_graph = true;
+            }
+            else if (option == "--by-length") {
+                config.partition_by_length = true;
+            }
+            else if (option == "--bloom") {
+                string value = optionValue(argc, argv, i);
+                char* end;
+                config.bloom_false_positive_rate = std::strtod(value.c_str(), &end);
+                if (*end != '\0' || !(config.bloom_false_positive_rate > 0 && config.bloom_false_positive_rate < 1)) {
+                    throw InvalidOption("Expected a rate between 0 and 1 for --bloom");
+                }
+            }
+            else if (option == "--symspell") {
+                fallbackValue(argc, argv, i, "symspell", config);
+            }
+            else if (option == "--trie") {
+                fallbackValue(argc, argv, i, "trie", config);
+            }
+            else if (option == "--symspell-memory") {
+                config.deletion_memory_mb = countValue(argc, argv, i);
+            }
+            else if (option == "--cache") {
+                config.cache_size = countValue(argc, argv, i);
+            }
+            else if (option == "--cache-file") {
+                config.cache_path = optionValue(argc, argv, i);
+            }
+            else if (option == "--top") {
+                config.top_suggestions = countValue(argc, argv, i);
+            }
+            else if (option == "--frequencies") {
+                config.frequency_path = optionValue(argc, argv, i);
+            }
+            else if (option == "--max-probes") {
+                config.max_probes = countValue(argc, argv, i);
+            }
+            else if (option == "--max-us") {
+                config.max_suggest_us = countValue(argc, argv, i);
+            }
+            else if (option == "-t" || option == "--threads") {
+                config.threads = countValue(argc, argv, i);
+            }
+            else if (option == "-j" || option == "--jobs") {
+                config.jobs = countValue(argc, argv, i);
+            }
+            else if (option == "--stream") {
+                config.stream = true;
+            }
+            else if (option == "--seen-cap") {
+                config.stream_seen_cap = countValue(argc, argv, i);
+            }
+            else if (option == "--serve") {
+                config.serve_path = optionValue(argc, argv, i);
+            }
+            else if (option == "--max-clients") {
+                config.max_clients = countValue(argc, argv, i);
+            }
+            else if (option == "--client") {
+                client_path = optionValue(argc, argv, i);
+            }
+            else if (option == "--format") {
+                config.report_format = optionValue(argc, argv, i);
+            }
+            else if (option == "--tree") {
+                config.use_tree = true;
+            }
+            else {
+                throw InvalidOption("Unknown option '" + option + "'");
+            }
+        }
+        if (config.use_word_graph && config.partition_by_length) {
+            throw InvalidOption("Only one of --dawg and --by-length may be given");
+        }
+        if (!client_path.empty() && i < argc) {
+            runClient(client_path, argv[i], std::vector<string>(argv + i + 1, argv + argc));
+            return 0;
+        }
+        if (i >= argc || (build_index && argc - i != 2)) {
+            usage();
+            return 1;
+        }
+        App app(argv[i], config);
+        if (build_index) {
+            app.writeIndex(argv[i+1]);
+            return 0;
+        }
+        if (!config.serve_path.empty()) {
+            app.serve(config.serve_path);
+        }
+        else if (config.stream) {
+            if (i + 1 == argc) {
+                app.stream("/dev/stdin");
+            }
+            for (++i; i < argc; ++i) {
+                app.stream(argv[i]);
+            }
+        }
+        else {
+            app.run(std::vector<string>(argv + i + 1, argv + argc));
+        }
+        app.saveCache();
+        return 0;
     }
-    App app(argv[1]);
-    for (int i = 2; i < argc; ++i) {
-        cout << endl << "Cheking file '" << argv[i] << "'." << endl;
-        app.run(argv[i]);
+    catch (const std::exception& e) {
+        cerr << "Error: " << e.what() << endl;
     }
     return 1;
 }
@@ -0,0 +1,110 @@
+
+#include "normalize.h"
+
+using std::vector;
+
+size_t normalizeScalar(const char* token, size_t len, char* out) {
+	size_t res = 0;
+	for (size_t i = 0; i < len; ++i) {
+		char lower = token[i] | 0x20;
+		if (static_cast<unsigned char>(lower - 'a') < 26) {
+			out[res++] = lower;
+		}
+	}
+	return res;
+}
+
+#if __x86_64__
+#include <immintrin.h>
+
+// Bytes are classified with a single signed comparison: OR-ing 0x20 maps
+// upper case letters to lower case (and no other byte to a letter), then
+// adding 0x80 - 'a' maps 'a'..'z' to the 26 smallest signed values.
+
+size_t normalizeSse2(const char* token, size_t len, char* out) {
+	const __m128i case_bit = _mm_set1_epi8(0x20);
+	const __m128i shift = _mm_set1_epi8(static_cast<char>(0x80 - 'a'));
+	const __m128i limit = _mm_set1_epi8(-128 + 26);
+	size_t res = 0;
+	for (size_t i = 0; i < len; i += 16) {
+		__m128i lower = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(token + i)), case_bit);
+		__m128i alpha = _mm_cmplt_epi8(_mm_add_epi8(lower, shift), limit);
+		unsigned mask = _mm_movemask_epi8(alpha);
+		// Bytes of the block which are part of the token
+		unsigned valid = len - i >= 16 ? 0xFFFF : (1u << (len - i)) - 1;
+		mask &= valid;
+		if (mask == valid) {
+			// Common case, nothing to drop
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + res), lower);
+			res += __builtin_popcount(valid);
+			continue;
+		}
+		alignas(16) char block[16];
+		_mm_store_si128(reinterpret_cast<__m128i*>(block), lower);
+		for (; mask != 0; mask &= mask - 1) {
+			out[res++] = block[__builtin_ctz(mask)];
+		}
+	}
+	return res;
+}
+
+__attribute__((target("avx2")))
+size_t normalizeAvx2(const char* token, size_t len, char* out) {
+	const __m256i case_bit = _mm256_set1_epi8(0x20);
+	const __m256i shift = _mm256_set1_epi8(static_cast<char>(0x80 - 'a'));
+	const __m256i limit = _mm256_set1_epi8(-128 + 26);
+	size_t res = 0;
+	for (size_t i = 0; i < len; i += 32) {
+		__m256i lower = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(token + i)), case_bit);
+		__m256i alpha = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(lower, shift));
+		uint32_t mask = _mm256_movemask_epi8(alpha);
+		uint32_t valid = len - i >= 32 ? 0xFFFFFFFF : (1u << (len - i)) - 1;
+		mask &= valid;
+		if (mask == valid) {
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + res), lower);
+			res += __builtin_popcount(valid);
+			continue;
+		}
+		alignas(32) char block[32];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(block), lower);
+		for (; mask != 0; mask &= mask - 1) {
+			out[res++] = block[__builtin_ctz(mask)];
+		}
+	}
+	return res;
+}
+
+static vector<Normalizer> listNormalizers() {
+	// May run before the CPU features are detected by the runtime
+	__builtin_cpu_init();
+	vector<Normalizer> res = {
+		{"scalar", normalizeScalar},
+		{"sse2", normalizeSse2}
+	};
+	if (__builtin_cpu_supports("avx2")) {
+		res.push_back({"avx2", normalizeAvx2});
+	}
+	return res;
+}
+#else
+size_t normalizeSse2(const char* token, size_t len, char* out) {
+	return normalizeScalar(token, len, out);
+}
+
+size_t normalizeAvx2(const char* token, size_t len, char* out) {
+	return normalizeScalar(token, len, out);
+}
+
+static vector<Normalizer> listNormalizers() {
+	return {{"scalar", normalizeScalar}};
+}
+#endif
+
+const vector<Normalizer>& availableNormalizers() {
+	static const vector<Normalizer> normalizers = listNormalizers();
+	return normalizers;
+}
+
+normalize_func_t bestNormalizer() {
+	return availableNormalizers().back().func;
+}
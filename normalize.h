@@ -0,0 +1,40 @@
+
+#ifndef NORMALIZE_H
+#define NORMALIZE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Kernels read and write whole vectors: the NORMALIZE_PADDING bytes following
+// a token must be readable, and the output must have room for
+// NORMALIZE_PADDING bytes more than the token
+constexpr size_t NORMALIZE_PADDING = 32;
+
+// Normalizes a token of len bytes into a word written to out: drops non
+// alphabetic characters ("C" locale), and lowercases the rest. Returns the
+// length of the word
+using normalize_func_t = size_t(*)(const char* token, size_t len, char* out);
+
+// Portable byte-at-a-time kernel
+size_t normalizeScalar(const char* token, size_t len, char* out);
+
+// 16 bytes at a time. Only call if the CPU supports SSE2
+size_t normalizeSse2(const char* token, size_t len, char* out);
+
+// 32 bytes at a time. Only call if the CPU supports AVX2
+size_t normalizeAvx2(const char* token, size_t len, char* out);
+
+// A normalization kernel, selectable by name
+struct Normalizer final {
+	const char* name;
+	normalize_func_t func;
+};
+
+// All kernels usable on the running CPU, slowest first
+const std::vector<Normalizer>& availableNormalizers();
+
+// Fastest kernel usable on the running CPU
+normalize_func_t bestNormalizer();
+
+#endif